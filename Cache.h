@@ -0,0 +1,367 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "Pattern.h"
+#include "RtCheck.h"
+
+struct BlockCacheStats
+{
+    std::uint64_t hits;
+    std::uint64_t misses;    // blocks rendered
+    std::uint64_t evictions;
+    size_t nodes;            // distinct live subgraphs
+    size_t blocks;           // blocks held
+};
+
+inline std::ostream &operator<<(std::ostream &os, const BlockCacheStats &stats)
+{
+    return os << "hits=" << stats.hits << " misses=" << stats.misses << " evictions=" << stats.evictions
+              << " nodes=" << stats.nodes << " blocks=" << stats.blocks;
+}
+
+// Hash-conses deterministic pattern subgraphs and shares their output.
+//
+// intern() takes a pattern over and returns a cursor onto it. Patterns with
+// equal signatures (see Pattern::signature) produce the same values, so they
+// all map onto one source node, which renders its output in fixed-size
+// blocks into a bounded LRU; every cursor copies those blocks out at its own
+// position. N tracks playing the same PLoop(PSequence(...)) then cost one
+// evaluation plus N block copies. A cursor that needs a block which has been
+// evicted after the source moved past it makes the source restart from
+// reset() and render forward again, so the capacity should cover the spread
+// between the leading and trailing cursor. Patterns without a signature are
+// returned unchanged.
+//
+// Blocks live in one arena of capacityBlocks x blockSize values allocated up
+// front, indexed by an intrusive hash table and LRU list over its slots, so a
+// miss evicts and refills a slot without touching the heap. Each node has its
+// own lock around its source; the cache-wide lock only covers the index and
+// the copy in or out of a slot, so different nodes render concurrently.
+class BlockCache
+{
+    struct Node;
+    struct Shared;
+
+public:
+    explicit BlockCache(size_t capacityBlocks = 1024, size_t blockSize = 256)
+    {
+        if (capacityBlocks == 0 || blockSize == 0)
+            throw std::invalid_argument("BlockCache capacity and block size must be positive");
+        shared = std::make_shared<Shared>(capacityBlocks, blockSize);
+    }
+
+    std::shared_ptr<Pattern> intern(std::shared_ptr<Pattern> pattern)
+    {
+        StateWriter signature;
+        if (!pattern->signature(signature)) return pattern;
+
+        std::lock_guard<RtMutex> lock(shared->mutex);
+        auto found = shared->nodes.find(signature.data());
+        std::shared_ptr<Node> node = found != shared->nodes.end() ? found->second.lock() : nullptr;
+        if (!node)
+        {
+            std::erase_if(shared->nodes, [](const auto &entry) { return entry.second.expired(); });
+            pattern->reset();
+            node = std::make_shared<Node>(shared->nextNodeId++, std::move(pattern));
+            shared->nodes[signature.data()] = node;
+        }
+        return std::make_shared<PCached>(shared, std::move(node));
+    }
+
+    BlockCacheStats stats() const
+    {
+        std::lock_guard<RtMutex> lock(shared->mutex);
+        size_t live = std::count_if(shared->nodes.begin(), shared->nodes.end(),
+                                    [](const auto &entry) { return !entry.second.expired(); });
+        return BlockCacheStats{shared->hits, shared->misses, shared->evictions, live, shared->used};
+    }
+
+    size_t getBlockSize() const
+    {
+        return shared->blockSize;
+    }
+
+private:
+    static constexpr std::uint64_t NoBlock = UINT64_MAX;
+
+    struct Node
+    {
+        Node(std::uint64_t id, std::shared_ptr<Pattern> source)
+            : id(id), source(std::move(source)), sourceBlock(0), lastBlock(NoBlock) {}
+
+        const std::uint64_t id;
+        std::shared_ptr<Pattern> source;
+        std::uint64_t sourceBlock;             // the block the source renders next
+        std::atomic<std::uint64_t> lastBlock;  // the first short block, once it is known
+        RtMutex mutex;                         // guards source and sourceBlock
+    };
+
+    struct BlockKey
+    {
+        std::uint64_t node;
+        std::uint64_t block;
+
+        bool operator==(const BlockKey &other) const = default;
+    };
+
+    // FNV-1a over the signature bytes.
+    struct SignatureHash
+    {
+        size_t operator()(const Snapshot &bytes) const
+        {
+            std::uint64_t hash = 0xcbf29ce484222325ull;
+            for (std::uint8_t byte : bytes)
+            {
+                hash = (hash ^ byte) * 0x100000001b3ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    struct Slot
+    {
+        BlockKey key;
+        size_t length;
+        std::int64_t prev;  // LRU neighbours, most recent first
+        std::int64_t next;
+        std::int64_t chain; // next slot in the same bucket
+    };
+
+    struct Shared
+    {
+        Shared(size_t capacity, size_t blockSize)
+            : capacity(capacity), blockSize(blockSize), arena(capacity * blockSize), slots(capacity),
+              buckets(std::bit_ceil(2 * capacity), -1), used(0), newest(-1), oldest(-1),
+              nextNodeId(0), hits(0), misses(0), evictions(0) {}
+
+        // Copies block index of node into out (blockSize values) and returns
+        // its length, rendering it, and any blocks before it the source has
+        // not reached, on a miss. 0 past the end of the source.
+        size_t fetch(Node &node, std::uint64_t index, double *out)
+        {
+            if (index > node.lastBlock.load(std::memory_order_acquire)) return 0;
+            size_t length;
+            if (lookup(BlockKey{node.id, index}, out, length)) return length;
+
+            std::lock_guard<RtMutex> nodeLock(node.mutex);
+            // Another cursor may have rendered it while this one waited.
+            if (lookup(BlockKey{node.id, index}, out, length)) return length;
+
+            if (node.sourceBlock > index)
+            {
+                node.source->reset();
+                node.sourceBlock = 0;
+            }
+            while (node.sourceBlock <= index)
+            {
+                length = node.source->nextBlock(out, blockSize);
+                if (length < blockSize) node.lastBlock.store(node.sourceBlock, std::memory_order_release);
+                insert(BlockKey{node.id, node.sourceBlock++}, out, length);
+                if (length < blockSize && node.sourceBlock <= index) return 0;
+            }
+            return length;
+        }
+
+        bool lookup(const BlockKey &key, double *out, size_t &length)
+        {
+            std::lock_guard<RtMutex> lock(mutex);
+            std::int64_t slot = find(key);
+            if (slot < 0) return false;
+            hits++;
+            unlink(slot);
+            pushFront(slot);
+            length = slots[slot].length;
+            std::copy_n(arena.data() + slot * blockSize, length, out);
+            return true;
+        }
+
+        void insert(const BlockKey &key, const double *values, size_t length)
+        {
+            std::lock_guard<RtMutex> lock(mutex);
+            misses++;
+            std::int64_t slot = find(key);
+            if (slot >= 0)
+            {
+                unlink(slot);
+            }
+            else if (used < capacity)
+            {
+                slot = static_cast<std::int64_t>(used++);
+                slots[slot].key = key;
+                chainIn(slot);
+            }
+            else
+            {
+                slot = oldest;
+                unlink(slot);
+                chainOut(slot);
+                evictions++;
+                slots[slot].key = key;
+                chainIn(slot);
+            }
+            slots[slot].length = length;
+            std::copy_n(values, length, arena.data() + slot * blockSize);
+            pushFront(slot);
+        }
+
+        size_t bucketOf(const BlockKey &key) const
+        {
+            return std::hash<std::uint64_t>()(key.node * 0x9e3779b97f4a7c15ull ^ key.block) & (buckets.size() - 1);
+        }
+
+        std::int64_t find(const BlockKey &key) const
+        {
+            std::int64_t slot = buckets[bucketOf(key)];
+            while (slot >= 0 && !(slots[slot].key == key)) slot = slots[slot].chain;
+            return slot;
+        }
+
+        void chainIn(std::int64_t slot)
+        {
+            std::int64_t &head = buckets[bucketOf(slots[slot].key)];
+            slots[slot].chain = head;
+            head = slot;
+        }
+
+        void chainOut(std::int64_t slot)
+        {
+            std::int64_t *link = &buckets[bucketOf(slots[slot].key)];
+            while (*link != slot) link = &slots[*link].chain;
+            *link = slots[slot].chain;
+        }
+
+        void unlink(std::int64_t slot)
+        {
+            Slot &entry = slots[slot];
+            if (entry.prev >= 0)
+                slots[entry.prev].next = entry.next;
+            else
+                newest = entry.next;
+            if (entry.next >= 0)
+                slots[entry.next].prev = entry.prev;
+            else
+                oldest = entry.prev;
+        }
+
+        void pushFront(std::int64_t slot)
+        {
+            slots[slot].prev = -1;
+            slots[slot].next = newest;
+            if (newest >= 0)
+                slots[newest].prev = slot;
+            else
+                oldest = slot;
+            newest = slot;
+        }
+
+        const size_t capacity;
+        const size_t blockSize;
+        std::vector<double> arena;          // capacity x blockSize values
+        std::vector<Slot> slots;
+        std::vector<std::int64_t> buckets;  // head slot per bucket, or -1
+        size_t used;                        // slots filled so far
+        std::int64_t newest;
+        std::int64_t oldest;
+        std::uint64_t nextNodeId;
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::unordered_map<Snapshot, std::weak_ptr<Node>, SignatureHash> nodes;
+        mutable RtMutex mutex;              // guards everything above but the constants
+    };
+
+public:
+    // PCached: one reader of a shared node, with its own position and a copy
+    // of the block it is reading.
+    class PCached : public Pattern
+    {
+    public:
+        PCached(std::shared_ptr<Shared> shared, std::shared_ptr<Node> node)
+            : shared(std::move(shared)), node(std::move(node)), position(0), blockIndex(NoBlock),
+              values(this->shared->blockSize), length(0) {}
+
+        void reset() override
+        {
+            position = 0;
+        }
+
+        double next() override
+        {
+            size_t offset = current();
+            if (offset >= length)
+                throw std::out_of_range("Cached pattern exhausted");
+            position++;
+            return values[offset];
+        }
+
+        size_t nextBlock(double *out, size_t count) override
+        {
+            size_t n = 0;
+            while (n < count)
+            {
+                size_t offset = current();
+                if (offset >= length) break;
+                size_t run = std::min(count - n, length - offset);
+                std::copy_n(values.data() + offset, run, out + n);
+                n += run;
+                position += run;
+            }
+            return n;
+        }
+
+        void save(StateWriter &out) const override
+        {
+            out.tag("PCAC");
+            out.write(position);
+        }
+
+        void load(StateReader &in) override
+        {
+            in.tag("PCAC");
+            in.read(position);
+        }
+
+        bool signature(StateWriter &out) const override
+        {
+            return node->source->signature(out);
+        }
+
+    private:
+        // Makes sure the block holding position is loaded; returns the offset
+        // into it.
+        size_t current()
+        {
+            std::uint64_t index = position / shared->blockSize;
+            if (index != blockIndex)
+            {
+                length = shared->fetch(*node, index, values.data());
+                blockIndex = index;
+            }
+            return position % shared->blockSize;
+        }
+
+        std::shared_ptr<Shared> shared;
+        std::shared_ptr<Node> node;
+        std::uint64_t position;
+        std::uint64_t blockIndex;
+        std::vector<double> values;
+        size_t length;
+    };
+
+private:
+    std::shared_ptr<Shared> shared;
+};
+
+#endif // CACHE_H
@@ -0,0 +1,131 @@
+#ifndef DICT_H
+#define DICT_H
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Pattern.h"
+
+// A block of note events stored as columns, one entry per event.
+struct NoteBlock
+{
+    std::vector<int> pitch;
+    std::vector<int> velocity;
+    std::vector<double> duration; // beats
+    std::vector<int> channel;
+
+    size_t size() const
+    {
+        return pitch.size();
+    }
+};
+
+// PDict: an event-level pattern built from one field per note property, each
+// either a constant or a Pattern. nextBlock() pulls each pattern field for the
+// whole block with one Pattern::nextBlock() call and fills constant fields
+// with a single std::fill, so there is no per-event virtual call or branching
+// on field kinds. The block ends where the shortest pattern field runs out;
+// values the other fields had already drawn past that point are kept, in
+// order, and handed out first by the next call, so none are lost if the
+// short field is reset or refilled.
+class PDict
+{
+public:
+    class Field
+    {
+    public:
+        Field(double constant) : constant(constant) {}
+
+        template <typename P>
+        Field(std::shared_ptr<P> pattern) : constant(0), pattern(std::move(pattern)) {}
+
+    private:
+        friend class PDict;
+
+        double constant;
+        std::shared_ptr<Pattern> pattern;
+        std::vector<double> carry; // drawn but not yet part of a block
+    };
+
+    PDict(Field pitch, Field velocity = 64.0, Field duration = 1.0, Field channel = 0.0)
+        : pitch(std::move(pitch)), velocity(std::move(velocity)), duration(std::move(duration)), channel(std::move(channel)) {}
+
+    void reset()
+    {
+        for (Field *field : {&pitch, &velocity, &duration, &channel})
+        {
+            if (field->pattern) field->pattern->reset();
+            field->carry.clear();
+        }
+    }
+
+    // Overwrites block with up to count events and returns how many there are.
+    size_t nextBlock(NoteBlock &block, size_t count)
+    {
+        block.pitch.resize(count);
+        block.velocity.resize(count);
+        block.duration.resize(count);
+        block.channel.resize(count);
+
+        size_t pitches = fill(pitch, block.pitch.data(), count);
+        size_t velocities = fill(velocity, block.velocity.data(), pitches);
+        size_t durations = fill(duration, block.duration.data(), velocities);
+        size_t n = fill(channel, block.channel.data(), durations);
+
+        keep(pitch, block.pitch.data(), n, pitches);
+        keep(velocity, block.velocity.data(), n, velocities);
+        keep(duration, block.duration.data(), n, durations);
+
+        block.pitch.resize(n);
+        block.velocity.resize(n);
+        block.duration.resize(n);
+        block.channel.resize(n);
+        return n;
+    }
+
+private:
+    template <typename T>
+    size_t fill(Field &field, T *column, size_t n)
+    {
+        if (!field.pattern)
+        {
+            std::fill_n(column, n, static_cast<T>(field.constant));
+            return n;
+        }
+
+        size_t carried = std::min(n, field.carry.size());
+        std::transform(field.carry.begin(), field.carry.begin() + carried, column, [](double v) { return static_cast<T>(v); });
+        field.carry.erase(field.carry.begin(), field.carry.begin() + carried);
+        column += carried;
+        n -= carried;
+
+        if constexpr (std::is_same_v<T, double>)
+        {
+            return carried + field.pattern->nextBlock(column, n);
+        }
+        else
+        {
+            if (scratch.size() < n) scratch.resize(n);
+            n = field.pattern->nextBlock(scratch.data(), n);
+            std::transform(scratch.data(), scratch.data() + n, column, [](double v) { return static_cast<T>(v); });
+            return carried + n;
+        }
+    }
+
+    // Puts a field's values past the end of the block back in front of its carry.
+    template <typename T>
+    void keep(Field &field, const T *column, size_t used, size_t drawn)
+    {
+        if (drawn > used) field.carry.insert(field.carry.begin(), column + used, column + drawn);
+    }
+
+    Field pitch;
+    Field velocity;
+    Field duration;
+    Field channel;
+    std::vector<double> scratch;
+};
+
+#endif // DICT_H
@@ -0,0 +1,280 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Pattern.h"
+
+// Recycles coroutine frames. Frames are rounded up to 64-byte size classes
+// and carved from 64 KiB chunks; a freed frame goes on its class's free list
+// and is reused by the next frame of that size, so once a program has warmed
+// up, creating, resetting and destroying generators never reaches the heap.
+// Frames above 2 KiB fall back to operator new. The lock is a spinlock held
+// for a few instructions, so frames can be made and freed on the clock thread.
+class FramePool
+{
+public:
+    static FramePool &instance()
+    {
+        static FramePool pool;
+        return pool;
+    }
+
+    void *allocate(size_t size)
+    {
+        size_t sizeClass = (size + Granularity - 1) / Granularity;
+        if (sizeClass > NumClasses) return ::operator new(size);
+
+        Lock lock(busy);
+        FreeBlock *&head = freeLists[sizeClass];
+        if (head)
+        {
+            FreeBlock *block = head;
+            head = block->next;
+            return block;
+        }
+        size_t bytes = sizeClass * Granularity;
+        if (static_cast<size_t>(chunkEnd - chunkPos) < bytes)
+        {
+            chunks.emplace_back(new (std::align_val_t(Granularity)) std::byte[ChunkSize]);
+            chunkPos = chunks.back().get();
+            chunkEnd = chunkPos + ChunkSize;
+        }
+        void *block = chunkPos;
+        chunkPos += bytes;
+        return block;
+    }
+
+    void deallocate(void *pointer, size_t size)
+    {
+        size_t sizeClass = (size + Granularity - 1) / Granularity;
+        if (sizeClass > NumClasses)
+        {
+            ::operator delete(pointer);
+            return;
+        }
+        Lock lock(busy);
+        FreeBlock *block = static_cast<FreeBlock *>(pointer);
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+    }
+
+    // Chunks taken from the heap so far.
+    size_t getChunks() const
+    {
+        Lock lock(busy);
+        return chunks.size();
+    }
+
+private:
+    static constexpr size_t Granularity = 64;
+    static constexpr size_t NumClasses = 32;
+    static constexpr size_t ChunkSize = 64 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    struct ChunkDeleter
+    {
+        void operator()(std::byte *chunk) const
+        {
+            ::operator delete[](chunk, std::align_val_t(Granularity));
+        }
+    };
+
+    struct Lock
+    {
+        explicit Lock(std::atomic_flag &flag) : flag(flag)
+        {
+            while (flag.test_and_set(std::memory_order_acquire))
+            {
+                while (flag.test(std::memory_order_relaxed)) {}
+            }
+        }
+
+        ~Lock()
+        {
+            flag.clear(std::memory_order_release);
+        }
+
+        std::atomic_flag &flag;
+    };
+
+    FramePool() : freeLists{}, chunkPos(nullptr), chunkEnd(nullptr) {}
+
+    mutable std::atomic_flag busy;
+    FreeBlock *freeLists[NumClasses + 1];
+    std::byte *chunkPos;
+    std::byte *chunkEnd;
+    std::vector<std::unique_ptr<std::byte[], ChunkDeleter>> chunks;
+};
+
+// Coroutine that co_yields values of type T, with its frame in the FramePool.
+// Resumed one value at a time by next(); an exception thrown in the body is
+// rethrown from next().
+template <typename T>
+class Generator
+{
+public:
+    struct promise_type
+    {
+        T value{};
+        std::exception_ptr error;
+
+        Generator get_return_object()
+        {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always yield_value(T next)
+        {
+            value = std::move(next);
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception()
+        {
+            error = std::current_exception();
+        }
+
+        static void *operator new(size_t size)
+        {
+            return FramePool::instance().allocate(size);
+        }
+
+        static void operator delete(void *pointer, size_t size)
+        {
+            FramePool::instance().deallocate(pointer, size);
+        }
+    };
+
+    Generator() = default;
+
+    Generator(Generator &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Generator &operator=(Generator &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Generator()
+    {
+        if (handle) handle.destroy();
+    }
+
+    // Runs the body to its next co_yield; false once it has returned.
+    bool next(T &out)
+    {
+        if (!handle || handle.done()) return false;
+        handle.resume();
+        if (handle.done())
+        {
+            if (handle.promise().error) std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+            return false;
+        }
+        out = handle.promise().value;
+        return true;
+    }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// PGenerator: a Pattern whose values come from a coroutine, e.g.
+//
+//     PGenerator fib([]() -> Generator<double> {
+//         double a = 0, b = 1;
+//         while (true) { co_yield a; b = a + std::exchange(a, b); }
+//     });
+//
+// reset() starts a fresh coroutine from the factory. The factory is kept for
+// the pattern's lifetime, so a lambda's captures outlive the coroutines.
+// Returning ends the pattern; an out_of_range from a pattern read inside the
+// body ends it too. Only Generator<double> is wrapped; generators of other
+// types, such as Event, are driven directly through Generator::next().
+class PGenerator : public Pattern
+{
+public:
+    using Factory = std::function<Generator<double>()>;
+
+    explicit PGenerator(Factory factory) : factory(std::move(factory)), produced(0)
+    {
+        generator = this->factory();
+    }
+
+    // The old coroutine is destroyed before the new one is made, so its frame
+    // goes back to the pool first and is the one reused.
+    void reset() override
+    {
+        generator = Generator<double>();
+        generator = factory();
+        produced = 0;
+    }
+
+    double next() override
+    {
+        double value;
+        if (!generator.next(value))
+            throw std::out_of_range("Generator exhausted");
+        produced++;
+        return value;
+    }
+
+    // A suspended coroutine frame cannot be written out, so the snapshot is
+    // the number of values taken and load() replays the body up to there.
+    // Exact for bodies that depend only on their own state.
+    void save(StateWriter &out) const override
+    {
+        out.tag("PGEN");
+        out.write(produced);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PGEN");
+        std::uint64_t target = in.read<std::uint64_t>();
+        reset();
+        double value;
+        while (produced < target && generator.next(value)) produced++;
+    }
+
+private:
+    Factory factory;
+    Generator<double> generator;
+    std::uint64_t produced;
+};
+
+#endif // GENERATOR_H
@@ -0,0 +1,268 @@
+#ifndef KEYDETECTOR_H
+#define KEYDETECTOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Key.h"
+#include "MidiReader.h"
+#include "ThreadPool.h"
+
+struct KeyEstimate
+{
+    Key key;
+    double correlation; // Pearson r against the key's profile, in [-1, 1]
+};
+
+// Krumhansl-Schmuckler key finding over a sliding window of notes.
+//
+// Every registered 12-tone scale at each of the 12 tonics is a candidate, with
+// a pitch-class profile: the Krumhansl-Kessler probe-tone ratings for major
+// and minor, and scale membership (tonic doubled) for other scales. The
+// estimate is the candidate whose profile correlates best with the window's
+// duration-weighted pitch-class histogram.
+//
+// Rather than recomputing K correlations from scratch, the detector keeps the
+// dot product of the histogram with every profile: a note entering or leaving
+// the window changes one histogram bin, so each dot product moves by
+// weight * profile[pitch class], one pass over K contiguous values. The
+// histogram's mean and variance are kept alongside and each profile's are
+// fixed, so estimate() is another O(K) pass. The window is a preallocated
+// ring, so add() never allocates.
+class KeyDetector
+{
+public:
+    // window: notes considered (0: every note since reset()).
+    explicit KeyDetector(size_t window = 64, const std::vector<Scale *> &scales = Scale::all())
+        : window(window), ring(window), head(0), count(0), total(0), totalSquares(0), updates(0)
+    {
+        std::vector<std::vector<double>> rotated;
+        for (Scale *scale : scales)
+        {
+            if (scale->getOctaveSize() != 12) continue;
+            std::vector<double> profile = profileFor(*scale);
+            double mean = 0;
+            for (double value : profile) mean += value / 12;
+            double deviation = 0;
+            for (double value : profile) deviation += (value - mean) * (value - mean);
+            for (int tonic = 0; tonic < 12; ++tonic)
+            {
+                candidates.push_back(Candidate{Key(tonic, scale), mean, std::sqrt(deviation)});
+                rotated.push_back(rotate(profile, tonic));
+            }
+        }
+        if (candidates.empty())
+            throw std::invalid_argument("Key detection needs at least one 12-tone scale");
+
+        const size_t k = candidates.size();
+        weights.resize(12 * k);
+        for (size_t c = 0; c < k; ++c)
+        {
+            for (int pc = 0; pc < 12; ++pc) weights[pc * k + c] = rotated[c][pc];
+        }
+        dots.assign(k, 0.0);
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(histogram, histogram + 12, 0.0);
+        std::fill(dots.begin(), dots.end(), 0.0);
+        head = 0;
+        count = 0;
+        total = 0;
+        totalSquares = 0;
+        updates = 0;
+    }
+
+    // Adds a note (a MIDI number; rests below 0 are ignored) weighted by, e.g.,
+    // its duration, dropping the oldest note once the window is full.
+    void add(int note, double weight = 1.0)
+    {
+        if (note < 0 || weight <= 0) return;
+        int pc = note % 12;
+        if (window)
+        {
+            if (count == window)
+            {
+                const Entry &oldest = ring[head];
+                change(oldest.pitchClass, -oldest.weight);
+            }
+            else
+            {
+                count++;
+            }
+            ring[head] = Entry{pc, weight};
+            head = (head + 1) % window;
+        }
+        else
+        {
+            count++;
+        }
+        change(pc, weight);
+
+        // Adding and removing the same products does not cancel exactly in
+        // floating point; rebuild from the histogram now and then.
+        if (++updates >= std::max<size_t>(window, 256)) rebuild();
+    }
+
+    // The best-correlated key so far; correlation is 0 while the window is
+    // empty or holds a single pitch class.
+    KeyEstimate estimate() const
+    {
+        double spread = std::sqrt(std::max(0.0, totalSquares - total * total / 12));
+        size_t best = 0;
+        double bestScore = -std::numeric_limits<double>::infinity();
+        for (size_t c = 0; c < candidates.size(); ++c)
+        {
+            double covariance = dots[c] - total * candidates[c].mean;
+            double score = covariance / candidates[c].deviation;
+            if (score > bestScore)
+            {
+                bestScore = score;
+                best = c;
+            }
+        }
+        double correlation = spread > 1e-12 ? bestScore / spread : 0.0;
+        return KeyEstimate{candidates[best].key, correlation};
+    }
+
+    // Correlation of the window with every candidate, in candidate order
+    // (scales in construction order, then tonic 0-11).
+    std::vector<KeyEstimate> scores() const
+    {
+        double spread = std::sqrt(std::max(0.0, totalSquares - total * total / 12));
+        std::vector<KeyEstimate> result;
+        result.reserve(candidates.size());
+        for (size_t c = 0; c < candidates.size(); ++c)
+        {
+            double covariance = dots[c] - total * candidates[c].mean;
+            result.push_back(KeyEstimate{candidates[c].key,
+                                         spread > 1e-12 ? covariance / (candidates[c].deviation * spread) : 0.0});
+        }
+        return result;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t numCandidates() const
+    {
+        return candidates.size();
+    }
+
+    // Key of each file from all of its notes, weighted by duration in beats.
+    // Files are spread over pool when one is given.
+    static std::vector<KeyEstimate> detect(const std::vector<std::shared_ptr<const MidiFile>> &files,
+                                           ThreadPool *pool = nullptr,
+                                           const std::vector<Scale *> &scales = Scale::all())
+    {
+        std::vector<KeyEstimate> results(files.size(), KeyEstimate{Key(), 0.0});
+        auto detectFile = [&](size_t i)
+        {
+            KeyDetector detector(0, scales);
+            const MidiFile &file = *files[i];
+            double beatsPerTick = 1.0 / std::max(1, file.getTicksPerBeat());
+            MidiNote note;
+            for (size_t t = 0; t < file.numTracks(); ++t)
+            {
+                MidiTrackReader reader = file.track(t);
+                while (reader.next(note))
+                {
+                    if (note.channel == 9) continue; // drums
+                    detector.add(note.note, std::max<Tick>(note.duration, 1) * beatsPerTick);
+                }
+            }
+            results[i] = detector.estimate();
+        };
+        if (pool)
+            pool->parallelFor(files.size(), detectFile);
+        else
+            for (size_t i = 0; i < files.size(); ++i) detectFile(i);
+        return results;
+    }
+
+private:
+    struct Entry
+    {
+        int pitchClass;
+        double weight;
+    };
+
+    struct Candidate
+    {
+        Key key;
+        double mean;
+        double deviation; // sqrt of the sum of squared deviations
+    };
+
+    static std::vector<double> profileFor(Scale &scale)
+    {
+        static const std::vector<double> major = {6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88};
+        static const std::vector<double> minor = {6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17};
+        if (scale.getName() == "major") return major;
+        if (scale.getName() == "minor") return minor;
+        std::vector<double> profile(12, 0.0);
+        for (int semitone : scale.getSemitones()) profile[((semitone % 12) + 12) % 12] = 1.0;
+        profile[0] += 1.0;
+        return profile;
+    }
+
+    static std::vector<double> rotate(const std::vector<double> &profile, int tonic)
+    {
+        std::vector<double> result(12);
+        for (int pc = 0; pc < 12; ++pc) result[(pc + tonic) % 12] = profile[pc];
+        return result;
+    }
+
+    void change(int pc, double delta)
+    {
+        const size_t k = dots.size();
+        const double *row = weights.data() + pc * k;
+        double *d = dots.data();
+        for (size_t c = 0; c < k; ++c) d[c] += delta * row[c];
+        double before = histogram[pc];
+        histogram[pc] += delta;
+        total += delta;
+        totalSquares += histogram[pc] * histogram[pc] - before * before;
+    }
+
+    void rebuild()
+    {
+        const size_t k = dots.size();
+        std::fill(dots.begin(), dots.end(), 0.0);
+        total = 0;
+        totalSquares = 0;
+        for (int pc = 0; pc < 12; ++pc)
+        {
+            if (std::abs(histogram[pc]) < 1e-9) histogram[pc] = 0;
+            const double *row = weights.data() + pc * k;
+            for (size_t c = 0; c < k; ++c) dots[c] += histogram[pc] * row[c];
+            total += histogram[pc];
+            totalSquares += histogram[pc] * histogram[pc];
+        }
+        updates = 0;
+    }
+
+    size_t window;
+    std::vector<Entry> ring;
+    size_t head;
+    size_t count;
+    double histogram[12];
+    double total;        // sum of the histogram
+    double totalSquares; // sum of squared bins
+    size_t updates;
+    std::vector<Candidate> candidates;
+    std::vector<double> weights; // 12 x K, pitch class major
+    std::vector<double> dots;    // histogram . profile, per candidate
+};
+
+#endif // KEYDETECTOR_H
@@ -0,0 +1,266 @@
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+#include "Timeline.h"
+#include "RingBuffer.h"
+
+struct LookaheadStats
+{
+    size_t fill;          // events queued in the ring
+    size_t capacity;
+    size_t highWater;     // largest fill seen
+    Tick ticksAhead;      // rendered position minus playhead
+    unsigned long underruns; // clock ticks that found the producer behind
+    unsigned long lateEvents; // events dispatched after their tick
+    unsigned long rerenders;  // lookahead windows discarded by live edits
+};
+
+// Pipelined playback: a producer thread renders the timeline lookaheadTicks
+// ahead of the playhead into an SPSC ring, and the clock thread only dequeues
+// and dispatches events that are due. Pattern evaluation therefore never runs
+// inside the clock callback.
+class LookaheadPipeline
+{
+public:
+    LookaheadPipeline(const std::shared_ptr<Timeline> &timeline, Tick lookaheadTicks, size_t capacity = 4096)
+        : timeline(timeline), lookahead(std::max<Tick>(1, lookaheadTicks)), ring(capacity),
+          clock(timeline->getTimeBase()),
+          running(false), playhead(timeline->getCurrentTick()), renderedTick(playhead.load()),
+          generation(0), highWater(0), underruns(0), lateEvents(0), rerenders(0), pendingPos(0)
+    {
+        clock.attachTarget([this]() { tick(); });
+    }
+
+    ~LookaheadPipeline()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        if (running) return;
+        running = true;
+        producer = std::thread(&LookaheadPipeline::produce, this);
+        clock.start();
+    }
+
+    void stop()
+    {
+        if (!running) return;
+        clock.stop();
+        running = false;
+        if (producer.joinable()) producer.join();
+    }
+
+    void attachOutput(const std::function<void(const Event &)> &callback)
+    {
+        outputCallback = callback;
+    }
+
+    // Applies a change to the timeline on the producer thread, then throws away
+    // the already rendered lookahead and renders it again from the playhead.
+    // Tracks the change adds start at the playhead.
+    void edit(const std::function<void(Timeline &)> &change)
+    {
+        std::lock_guard<std::mutex> lock(editMutex);
+        edits.push_back(change);
+    }
+
+    // Clock callback: dispatches everything due at the playhead. Runs on the
+    // clock thread and never blocks or evaluates patterns.
+    void tick()
+    {
+        Tick now = playhead.load(std::memory_order_relaxed);
+
+        if (renderedTick.load(std::memory_order_acquire) <= now)
+        {
+            underruns.fetch_add(1, std::memory_order_relaxed);
+            ISOBAR_TRACE_ERROR("lookahead underrun", -1, now);
+        }
+
+        while (const Scheduled *next = ring.front())
+        {
+            // Generations only grow, so anything not from the latest one is stale.
+            if (next->generation != generation.load(std::memory_order_acquire))
+            {
+                ring.discard();
+                continue;
+            }
+            if (next->event.tick > now) break;
+            if (next->event.tick < now)
+            {
+                lateEvents.fetch_add(1, std::memory_order_relaxed);
+                ISOBAR_TRACE_ERROR("late event", next->event);
+            }
+            if (outputCallback) outputCallback(next->event);
+            ring.discard();
+        }
+
+        playhead.store(now + 1, std::memory_order_release);
+    }
+
+    LookaheadStats stats() const
+    {
+        LookaheadStats s;
+        s.fill = ring.size();
+        s.capacity = ring.capacity();
+        s.highWater = highWater.load(std::memory_order_relaxed);
+        s.ticksAhead = renderedTick.load(std::memory_order_relaxed) - playhead.load(std::memory_order_relaxed);
+        s.underruns = underruns.load(std::memory_order_relaxed);
+        s.lateEvents = lateEvents.load(std::memory_order_relaxed);
+        s.rerenders = rerenders.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    Tick getPlayhead() const
+    {
+        return playhead.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Scheduled
+    {
+        Event event;
+        unsigned generation;
+    };
+
+    void produce()
+    {
+        // Render in slices of a quarter of the window so the ring is topped up
+        // smoothly rather than in one burst per window.
+        const Tick slice = std::max<Tick>(1, lookahead / 4);
+        const auto idle = std::chrono::microseconds(500);
+
+        while (running)
+        {
+            applyEdits();
+
+            if (!flushPending())
+            {
+                std::this_thread::sleep_for(idle);
+                continue;
+            }
+
+            Tick target = playhead.load(std::memory_order_acquire) + lookahead;
+            Tick rendered = renderedTick.load(std::memory_order_relaxed);
+            if (rendered >= target)
+            {
+                std::this_thread::sleep_for(idle);
+                continue;
+            }
+
+            Tick numTicks = std::min(slice, target - rendered);
+            remember(rendered);
+            pending.clear();
+            pendingPos = 0;
+            timeline->render(numTicks, pending);
+            flushPending();
+            renderedTick.store(rendered + numTicks, std::memory_order_release);
+        }
+    }
+
+    // Pushes as much of the pending slice as fits; returns true once it is empty.
+    bool flushPending()
+    {
+        unsigned current = generation.load(std::memory_order_relaxed);
+        while (pendingPos < pending.size())
+        {
+            if (!ring.push(Scheduled{pending[pendingPos], current})) break;
+            pendingPos++;
+        }
+
+        size_t fill = ring.size();
+        if (fill > highWater.load(std::memory_order_relaxed))
+        {
+            highWater.store(fill, std::memory_order_relaxed);
+        }
+        return pendingPos == pending.size();
+    }
+
+    void applyEdits()
+    {
+        std::vector<std::function<void(Timeline &)>> batch;
+        {
+            std::lock_guard<std::mutex> lock(editMutex);
+            if (edits.empty()) return;
+            batch.swap(edits);
+        }
+
+        // Invalidate everything in flight before the timeline changes under it.
+        generation.fetch_add(1, std::memory_order_acq_rel);
+        pending.clear();
+        pendingPos = 0;
+
+        Tick from = playhead.load(std::memory_order_acquire);
+        rewind(from);
+        for (auto &change : batch)
+        {
+            change(*timeline);
+        }
+        snapshots.clear();
+        renderedTick.store(from, std::memory_order_release);
+        rerenders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Saves the timeline's state at the start of each slice, keeping only what
+    // a rewind to the playhead can still need.
+    void remember(Tick tick)
+    {
+        Tick now = playhead.load(std::memory_order_acquire);
+        while (snapshots.size() > 1 && snapshots[1].first <= now) snapshots.pop_front();
+        snapshots.emplace_back(tick, timeline->saveState());
+    }
+
+    // Puts the timeline back at tick: restores the last slice start at or
+    // before it and replays (and discards) the rest, at most one slice.
+    // Without such a snapshot, falls back to seek(), which replays from 0.
+    void rewind(Tick tick)
+    {
+        auto found = std::find_if(snapshots.rbegin(), snapshots.rend(),
+                                  [tick](const auto &snapshot) { return snapshot.first <= tick; });
+        if (found == snapshots.rend())
+        {
+            timeline->seek(tick);
+            return;
+        }
+        timeline->loadState(found->second);
+        if (tick > found->first)
+        {
+            std::vector<Event> discarded;
+            timeline->render(tick - found->first, discarded);
+        }
+    }
+
+    std::shared_ptr<Timeline> timeline;
+    Tick lookahead;
+    RingBuffer<Scheduled> ring;
+    Clock clock;
+    std::thread producer;
+    std::atomic<bool> running;
+    std::atomic<Tick> playhead;
+    std::atomic<Tick> renderedTick;
+    std::atomic<unsigned> generation;
+    std::atomic<size_t> highWater;
+    std::atomic<unsigned long> underruns;
+    std::atomic<unsigned long> lateEvents;
+    std::atomic<unsigned long> rerenders;
+    std::vector<Event> pending;
+    size_t pendingPos;
+    std::deque<std::pair<Tick, Snapshot>> snapshots; // slice starts, oldest first
+    std::mutex editMutex;
+    std::vector<std::function<void(Timeline &)>> edits;
+    std::function<void(const Event &)> outputCallback;
+};
+
+#endif // LOOKAHEAD_H
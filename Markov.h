@@ -0,0 +1,415 @@
+#ifndef MARKOV_H
+#define MARKOV_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "Pattern.h"
+#include "ThreadPool.h"
+
+// Order-k Markov model over the distinct values of a corpus, stored in
+// compressed sparse row form: the transitions of state s are the entries
+// [rowOffsets[s], rowOffsets[s + 1]) of flat per-transition arrays, which also
+// hold each row's alias table (Vose) for O(1) sampling and the index of the
+// state the transition leads to. A model is a handful of vectors whatever the
+// number of states.
+//
+// A context of k symbols plus the following symbol is packed into one 64-bit
+// key, 64 / (k + 1) bits per symbol, so the alphabet must fit that width:
+// 2^32 - 1 values at order 1 (the last code is NoState), 256 (all MIDI
+// notes) up to order 7.
+class MarkovModel
+{
+public:
+    static constexpr std::uint32_t NoState = 0xffffffffu;
+
+    // Counts transitions shard by shard on pool (or the calling thread), merges
+    // the sorted shard counts and builds the tables. Transitions never span two
+    // sequences of the corpus.
+    static std::shared_ptr<const MarkovModel> train(const std::vector<std::span<const double>> &corpus, int order,
+                                                    ThreadPool *pool = nullptr, size_t shardSize = 1 << 16)
+    {
+        if (order < 1 || order > 7)
+            throw std::invalid_argument("Markov order must be between 1 and 7");
+
+        std::shared_ptr<MarkovModel> model(new MarkovModel(order));
+        std::vector<Shard> shards = makeShards(corpus, order, shardSize);
+        auto run = [pool](size_t count, const std::function<void(size_t)> &body)
+        {
+            if (pool)
+                pool->parallelFor(count, body);
+            else
+                for (size_t i = 0; i < count; ++i) body(i);
+        };
+
+        // Alphabet: sorted distinct values, merged from per-shard sets.
+        std::vector<std::vector<double>> values(shards.size());
+        run(shards.size(), [&](size_t i)
+        {
+            const Shard &shard = shards[i];
+            values[i].assign(corpus[shard.sequence].begin() + shard.begin, corpus[shard.sequence].begin() + shard.end);
+            std::sort(values[i].begin(), values[i].end());
+            values[i].erase(std::unique(values[i].begin(), values[i].end()), values[i].end());
+        });
+        mergeRounds<double>(values, run, [](std::vector<double> &out, const std::vector<double> &a, const std::vector<double> &b)
+        {
+            std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+        });
+        if (!values.empty()) model->alphabet = std::move(values[0]);
+        if (model->alphabet.size() > std::min<std::uint64_t>(model->symbolMask() + 1, NoState))
+            throw std::invalid_argument("Too many distinct values for a Markov model of this order");
+
+        // Transition counts: each shard sorts its packed keys and run-length
+        // encodes them; shards are then merged pairwise, summing equal keys.
+        std::vector<std::vector<Count>> counts(shards.size());
+        run(shards.size(), [&](size_t i)
+        {
+            const Shard &shard = shards[i];
+            std::span<const double> sequence = corpus[shard.sequence];
+            std::vector<std::uint64_t> keys;
+            keys.reserve(shard.windows);
+            std::uint64_t key = 0;
+            for (size_t p = shard.begin; p < shard.end; ++p)
+            {
+                key = (key << model->bits) | model->symbolOf(sequence[p]);
+                if (p - shard.begin >= static_cast<size_t>(order)) keys.push_back(key & model->keyMask());
+            }
+            std::sort(keys.begin(), keys.end());
+            for (std::uint64_t k : keys)
+            {
+                if (!counts[i].empty() && counts[i].back().key == k)
+                    counts[i].back().count++;
+                else
+                    counts[i].push_back(Count{k, 1});
+            }
+        });
+        mergeRounds<Count>(counts, run, [](std::vector<Count> &out, const std::vector<Count> &a, const std::vector<Count> &b)
+        {
+            size_t i = 0, j = 0;
+            while (i < a.size() || j < b.size())
+            {
+                if (j == b.size() || (i < a.size() && a[i].key < b[j].key))
+                    out.push_back(a[i++]);
+                else if (i == a.size() || b[j].key < a[i].key)
+                    out.push_back(b[j++]);
+                else
+                    out.push_back(Count{a[i].key, a[i++].count + b[j++].count});
+            }
+        });
+        if (!counts.empty()) model->build(counts[0]);
+        return model;
+    }
+
+    static std::shared_ptr<const MarkovModel> train(const std::vector<std::vector<double>> &corpus, int order,
+                                                    ThreadPool *pool = nullptr, size_t shardSize = 1 << 16)
+    {
+        std::vector<std::span<const double>> spans(corpus.begin(), corpus.end());
+        return train(spans, order, pool, shardSize);
+    }
+
+    int getOrder() const
+    {
+        return order;
+    }
+
+    size_t numStates() const
+    {
+        return contexts.size();
+    }
+
+    size_t numTransitions() const
+    {
+        return symbols.size();
+    }
+
+    const std::vector<double> &getAlphabet() const
+    {
+        return alphabet;
+    }
+
+    // Number of times value followed the given context in the corpus.
+    std::uint64_t count(std::span<const double> context, double value) const
+    {
+        if (context.size() != static_cast<size_t>(order)) return 0;
+        std::uint64_t code = 0;
+        for (double v : context)
+        {
+            std::uint32_t symbol = findSymbol(v);
+            if (symbol == NoState) return 0;
+            code = (code << bits) | symbol;
+        }
+        std::uint32_t state = findState(code);
+        std::uint32_t symbol = findSymbol(value);
+        if (state == NoState || symbol == NoState) return 0;
+        for (std::uint32_t t = rowOffsets[state]; t < rowOffsets[state + 1]; ++t)
+        {
+            if (symbols[t] == symbol) return counts[t];
+        }
+        return 0;
+    }
+
+    // Picks a transition out of state with the alias method: one uniform
+    // index, one uniform real, one comparison.
+    template <typename Rng>
+    std::uint32_t sample(std::uint32_t state, Rng &rng) const
+    {
+        std::uint32_t begin = rowOffsets[state];
+        std::uint32_t width = rowOffsets[state + 1] - begin;
+        std::uint32_t column = std::uniform_int_distribution<std::uint32_t>(0, width - 1)(rng);
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return begin + (u < probability[begin + column] ? column : alias[begin + column]);
+    }
+
+    double valueOf(std::uint32_t transition) const
+    {
+        return alphabet[symbols[transition]];
+    }
+
+    std::uint32_t targetOf(std::uint32_t transition) const
+    {
+        return targets[transition];
+    }
+
+private:
+    struct Shard
+    {
+        size_t sequence;
+        size_t begin; // first value read; windows end at positions begin + order ... end - 1
+        size_t end;
+        size_t windows;
+    };
+
+    struct Count
+    {
+        std::uint64_t key;
+        std::uint64_t count;
+    };
+
+    explicit MarkovModel(int order) : order(order), bits(64 / (order + 1)) {}
+
+    std::uint64_t symbolMask() const
+    {
+        return (std::uint64_t(1) << bits) - 1;
+    }
+
+    std::uint64_t keyMask() const
+    {
+        return bits * (order + 1) >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << (bits * (order + 1))) - 1;
+    }
+
+    std::uint64_t contextMask() const
+    {
+        return (std::uint64_t(1) << (bits * order)) - 1;
+    }
+
+    std::uint32_t symbolOf(double value) const
+    {
+        return static_cast<std::uint32_t>(std::lower_bound(alphabet.begin(), alphabet.end(), value) - alphabet.begin());
+    }
+
+    std::uint32_t findSymbol(double value) const
+    {
+        auto it = std::lower_bound(alphabet.begin(), alphabet.end(), value);
+        return it != alphabet.end() && *it == value ? static_cast<std::uint32_t>(it - alphabet.begin()) : NoState;
+    }
+
+    std::uint32_t findState(std::uint64_t context) const
+    {
+        auto it = std::lower_bound(contexts.begin(), contexts.end(), context);
+        return it != contexts.end() && *it == context ? static_cast<std::uint32_t>(it - contexts.begin()) : NoState;
+    }
+
+    // Splits every sequence into ranges of about shardSize windows; consecutive
+    // shards overlap by order values so no window is lost or counted twice.
+    static std::vector<Shard> makeShards(const std::vector<std::span<const double>> &corpus, int order, size_t shardSize)
+    {
+        std::vector<Shard> shards;
+        shardSize = std::max<size_t>(shardSize, 1);
+        for (size_t s = 0; s < corpus.size(); ++s)
+        {
+            size_t size = corpus[s].size();
+            if (size <= static_cast<size_t>(order)) continue;
+            for (size_t first = order; first < size; first += shardSize)
+            {
+                size_t last = std::min(size, first + shardSize);
+                shards.push_back(Shard{s, first - order, last, last - first});
+            }
+        }
+        return shards;
+    }
+
+    // Reduces parts to one by merging neighbours pairwise, each round in parallel.
+    template <typename T, typename Run, typename Merge>
+    static void mergeRounds(std::vector<std::vector<T>> &parts, Run &run, Merge merge)
+    {
+        while (parts.size() > 1)
+        {
+            std::vector<std::vector<T>> merged((parts.size() + 1) / 2);
+            run(merged.size(), [&](size_t i)
+            {
+                if (2 * i + 1 < parts.size())
+                {
+                    merged[i].reserve(parts[2 * i].size() + parts[2 * i + 1].size());
+                    merge(merged[i], parts[2 * i], parts[2 * i + 1]);
+                }
+                else
+                {
+                    merged[i] = std::move(parts[2 * i]);
+                }
+            });
+            parts = std::move(merged);
+        }
+    }
+
+    // Lays out the CSR rows from the merged, sorted counts and fills in each
+    // row's alias table and each transition's target state.
+    void build(const std::vector<Count> &merged)
+    {
+        rowOffsets.push_back(0);
+        for (const Count &entry : merged)
+        {
+            std::uint64_t context = entry.key >> bits;
+            if (contexts.empty() || contexts.back() != context)
+            {
+                if (!contexts.empty()) rowOffsets.push_back(static_cast<std::uint32_t>(symbols.size()));
+                contexts.push_back(context);
+            }
+            symbols.push_back(static_cast<std::uint32_t>(entry.key & symbolMask()));
+            counts.push_back(static_cast<std::uint32_t>(std::min<std::uint64_t>(entry.count, 0xffffffffu)));
+        }
+        if (!contexts.empty()) rowOffsets.push_back(static_cast<std::uint32_t>(symbols.size()));
+
+        targets.resize(symbols.size());
+        probability.resize(symbols.size());
+        alias.resize(symbols.size());
+        std::vector<double> scaled;
+        std::vector<std::uint32_t> small, large;
+        for (std::uint32_t state = 0; state < contexts.size(); ++state)
+        {
+            std::uint32_t begin = rowOffsets[state], end = rowOffsets[state + 1];
+            for (std::uint32_t t = begin; t < end; ++t)
+            {
+                targets[t] = findState(((contexts[state] << bits) | symbols[t]) & contextMask());
+            }
+            buildAlias(begin, end, scaled, small, large);
+        }
+    }
+
+    void buildAlias(std::uint32_t begin, std::uint32_t end, std::vector<double> &scaled,
+                    std::vector<std::uint32_t> &small, std::vector<std::uint32_t> &large)
+    {
+        std::uint32_t width = end - begin;
+        double total = 0;
+        for (std::uint32_t t = begin; t < end; ++t) total += counts[t];
+
+        scaled.resize(width);
+        small.clear();
+        large.clear();
+        for (std::uint32_t i = 0; i < width; ++i)
+        {
+            scaled[i] = static_cast<double>(counts[begin + i]) * width / total;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+        while (!small.empty() && !large.empty())
+        {
+            std::uint32_t s = small.back(), l = large.back();
+            small.pop_back();
+            probability[begin + s] = static_cast<float>(scaled[s]);
+            alias[begin + s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0)
+            {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        for (std::uint32_t i : large) probability[begin + i] = 1.0f;
+        for (std::uint32_t i : small) probability[begin + i] = 1.0f; // rounding leftovers
+    }
+
+    int order;
+    int bits;
+    std::vector<double> alphabet;
+    std::vector<std::uint64_t> contexts;    // per state, sorted
+    std::vector<std::uint32_t> rowOffsets;  // per state + 1
+    std::vector<std::uint32_t> symbols;     // per transition
+    std::vector<std::uint32_t> counts;
+    std::vector<std::uint32_t> targets;
+    std::vector<float> probability;
+    std::vector<std::uint32_t> alias;
+};
+
+// PMarkov: walks a trained model. Starts (and restarts, after reaching a
+// context that was never continued in the corpus) from a uniformly chosen
+// state; reset() reseeds, so the output is reproducible per seed.
+class PMarkov : public Pattern
+{
+public:
+    PMarkov(std::shared_ptr<const MarkovModel> model, std::uint64_t seed = 0)
+        : model(std::move(model)), seed(seed), rng(seed), state(MarkovModel::NoState)
+    {
+        if (this->model->numStates() == 0)
+            throw std::invalid_argument("Markov model has no transitions");
+    }
+
+    void reset() override
+    {
+        rng.seed(seed);
+        state = MarkovModel::NoState;
+    }
+
+    double next() override
+    {
+        if (state == MarkovModel::NoState)
+        {
+            state = std::uniform_int_distribution<std::uint32_t>(
+                0, static_cast<std::uint32_t>(model->numStates() - 1))(rng);
+        }
+        std::uint32_t transition = model->sample(state, rng);
+        state = model->targetOf(transition);
+        return model->valueOf(transition);
+    }
+
+    // The generator is stored as its raw words, which is exact and cheap but
+    // ties the snapshot to the standard library it was written with.
+    void save(StateWriter &out) const override
+    {
+        out.tag("PMKV");
+        out.write(rng);
+        out.write(state);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PMKV");
+        in.read(rng);
+        in.read(state);
+        if (state != MarkovModel::NoState && state >= model->numStates())
+            throw std::runtime_error("Snapshot state outside Markov model");
+    }
+
+    // Models are immutable once trained, so the same model object and seed
+    // always give the same walk.
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PMKV");
+        out.write(model.get());
+        out.write(seed);
+        return true;
+    }
+
+private:
+    std::shared_ptr<const MarkovModel> model;
+    std::uint64_t seed;
+    std::mt19937_64 rng;
+    std::uint32_t state;
+};
+
+#endif // MARKOV_H
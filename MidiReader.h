@@ -0,0 +1,432 @@
+#ifndef MIDIREADER_H
+#define MIDIREADER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Pattern.h"
+#include "Time.h"
+
+// A note decoded from a MIDI track; duration is the distance to its note-off.
+struct MidiNote
+{
+    Tick tick;
+    Tick duration;
+    int channel;
+    int note;
+    int velocity;
+};
+
+// Cursor over one MTrk chunk of a mapped file. Decodes lazily, one message at a
+// time, straight from the mapping, in a single pass: a note-on waits in a
+// queue, indexed by (channel, note) in a table of open notes, until the
+// note-off that closes it has been decoded, and notes leave the queue in
+// onset order. Only the notes between the oldest open one and the read
+// position are held.
+class MidiTrackReader
+{
+public:
+    MidiTrackReader(const std::uint8_t *begin, const std::uint8_t *end)
+        : begin(begin), end(end), pos(begin), tick(0), runningStatus(0), queueBase(0), open(16 * 128, -1) {}
+
+    void reset()
+    {
+        pos = begin;
+        tick = 0;
+        runningStatus = 0;
+        queue.clear();
+        queueBase = 0;
+        std::fill(open.begin(), open.end(), -1);
+    }
+
+    // Advances to the next note-on, with its duration taken from the first
+    // note-off for the same channel and note after it. Returns false at the end
+    // of the track.
+    bool next(MidiNote &note)
+    {
+        while (queue.empty() || !queue.front().closed)
+        {
+            if (!decodeNote()) break;
+        }
+        if (queue.empty()) return false;
+        note = queue.front().note;
+        queue.pop_front();
+        queueBase++;
+        return true;
+    }
+
+    // Onset of the note next() returns next, or the end of the track if there
+    // is none; consumes nothing.
+    Tick nextOnset()
+    {
+        while (queue.empty())
+        {
+            if (!decodeNote()) return tick;
+        }
+        return queue.front().note.tick;
+    }
+
+    // Block form of next(); returns how many notes were written to out.
+    size_t read(MidiNote *out, size_t count)
+    {
+        size_t n = 0;
+        while (n < count && next(out[n])) n++;
+        return n;
+    }
+
+    // Read position, running status and the notes waiting for their note-off.
+    void save(StateWriter &out) const
+    {
+        out.write<std::uint64_t>(static_cast<std::uint64_t>(pos - begin));
+        out.write(tick);
+        out.write(runningStatus);
+        out.write(queueBase);
+        out.write(std::vector<Pending>(queue.begin(), queue.end()));
+        out.write(open);
+    }
+
+    void load(StateReader &in)
+    {
+        std::uint64_t offset = in.read<std::uint64_t>();
+        Tick newTick = in.read<Tick>();
+        std::uint8_t status = in.read<std::uint8_t>();
+        std::int64_t base = in.read<std::int64_t>();
+        std::vector<Pending> pending;
+        in.read(pending);
+        std::vector<std::int64_t> table;
+        in.read(table);
+        if (offset > static_cast<std::uint64_t>(end - begin) || table.size() != open.size())
+            throw std::runtime_error("Snapshot does not match MIDI track");
+        pos = begin + offset;
+        tick = newTick;
+        runningStatus = status;
+        queueBase = base;
+        queue.assign(pending.begin(), pending.end());
+        open.swap(table);
+    }
+
+private:
+    struct Message
+    {
+        Tick tick;
+        std::uint8_t type;    // status high nibble
+        std::uint8_t channel;
+        std::uint8_t data1;
+        std::uint8_t data2;
+    };
+
+    struct Pending
+    {
+        MidiNote note;
+        bool closed;
+        std::int64_t nextOpen; // queue position of an older open note of the same key, or -1
+    };
+
+    // Decodes one message into the queue and open table. At the end of the
+    // track, closes the notes still open there and returns false.
+    bool decodeNote()
+    {
+        Message message;
+        if (!decode(message))
+        {
+            for (Pending &pending : queue)
+            {
+                if (!pending.closed) close(pending); // unterminated note: sustain to end of track
+            }
+            std::fill(open.begin(), open.end(), -1);
+            pos = end;
+            return false;
+        }
+
+        std::int64_t &head = open[message.channel * 128 + message.data1];
+        if (message.type == 0x90)
+        {
+            queue.push_back(Pending{MidiNote{message.tick, 0, message.channel, message.data1, message.data2}, false, head});
+            head = queueBase + static_cast<std::int64_t>(queue.size()) - 1;
+        }
+        else if (message.type == 0x80)
+        {
+            for (std::int64_t at = head; at >= 0;)
+            {
+                Pending &pending = queue[at - queueBase];
+                close(pending);
+                at = pending.nextOpen;
+            }
+            head = -1;
+        }
+        return true;
+    }
+
+    void close(Pending &pending)
+    {
+        pending.note.duration = tick - pending.note.tick;
+        pending.closed = true;
+    }
+
+    bool decode(Message &message)
+    {
+        while (pos < end)
+        {
+            tick += readVarLen();
+            if (pos >= end) return false;
+
+            std::uint8_t status = *pos;
+            if (status & 0x80)
+            {
+                pos++;
+            }
+            else
+            {
+                status = runningStatus;
+                if (!(status & 0x80)) throw std::runtime_error("Corrupt MIDI track: data byte without status");
+            }
+
+            // Meta and system exclusive events cancel running status.
+            if (status == 0xff)
+            {
+                runningStatus = 0;
+                if (pos >= end) return false;
+                std::uint8_t metaType = *pos++;
+                skip(readVarLen());
+                if (metaType == 0x2f) return false; // End of Track
+                continue;
+            }
+            if (status == 0xf0 || status == 0xf7)
+            {
+                runningStatus = 0;
+                skip(readVarLen());
+                continue;
+            }
+
+            runningStatus = status;
+            message.tick = tick;
+            message.type = status & 0xf0;
+            message.channel = status & 0x0f;
+            message.data1 = pos < end ? *pos++ : 0;
+            bool twoBytes = message.type != 0xc0 && message.type != 0xd0;
+            message.data2 = twoBytes && pos < end ? *pos++ : 0;
+
+            // Normalise note-on with velocity 0 to a note-off.
+            if (message.type == 0x90 && message.data2 == 0) message.type = 0x80;
+            return true;
+        }
+        return false;
+    }
+
+    void skip(Tick length)
+    {
+        pos = length < end - pos ? pos + length : end;
+    }
+
+    Tick readVarLen()
+    {
+        Tick value = 0;
+        for (int i = 0; i < 4 && pos < end; ++i)
+        {
+            std::uint8_t byte = *pos++;
+            value = (value << 7) | (byte & 0x7f);
+            if (!(byte & 0x80)) break;
+        }
+        return value;
+    }
+
+    const std::uint8_t *begin;
+    const std::uint8_t *end;
+    const std::uint8_t *pos;
+    Tick tick;
+    std::uint8_t runningStatus;
+    std::deque<Pending> queue;
+    std::int64_t queueBase;         // position of queue.front() among the track's notes
+    std::vector<std::int64_t> open; // newest open note per channel * 128 + note, or -1
+};
+
+// A Standard MIDI File mapped read-only into memory. Opening parses only the
+// header and the chunk table, so even very large files open instantly; tracks
+// are decoded on demand by MidiTrackReader. Share it through the shared_ptr so
+// patterns keep the mapping alive.
+class MidiFile
+{
+public:
+    static std::shared_ptr<const MidiFile> open(const std::string &path)
+    {
+        return std::shared_ptr<const MidiFile>(new MidiFile(path));
+    }
+
+    ~MidiFile()
+    {
+        if (data) ::munmap(const_cast<std::uint8_t *>(data), size);
+    }
+
+    MidiFile(const MidiFile &) = delete;
+    MidiFile &operator=(const MidiFile &) = delete;
+
+    int getFormat() const
+    {
+        return format;
+    }
+
+    int getTicksPerBeat() const
+    {
+        return ticksPerBeat;
+    }
+
+    size_t numTracks() const
+    {
+        return tracks.size();
+    }
+
+    MidiTrackReader track(size_t index) const
+    {
+        if (index >= tracks.size())
+            throw std::out_of_range("MIDI track index out of range");
+        return MidiTrackReader(tracks[index].first, tracks[index].second);
+    }
+
+private:
+    explicit MidiFile(const std::string &path)
+        : data(nullptr), size(0), format(0), ticksPerBeat(0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Could not open MIDI file: " + path);
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size < 14)
+        {
+            ::close(fd);
+            throw std::runtime_error("Not a MIDI file: " + path);
+        }
+        size = static_cast<size_t>(info.st_size);
+        void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+            throw std::runtime_error("Could not map MIDI file: " + path);
+        data = static_cast<const std::uint8_t *>(mapping);
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+        try
+        {
+            parseChunks(path);
+        }
+        catch (...)
+        {
+            ::munmap(mapping, size);
+            data = nullptr;
+            throw;
+        }
+    }
+
+    void parseChunks(const std::string &path)
+    {
+        if (!matches(data, "MThd") || read32(data + 4) < 6)
+            throw std::runtime_error("Missing MThd header: " + path);
+
+        format = read16(data + 8);
+        int division = read16(data + 12);
+        if (division & 0x8000)
+            throw std::runtime_error("SMPTE time division is not supported: " + path);
+        ticksPerBeat = division;
+
+        const std::uint8_t *pos = data + 8 + read32(data + 4);
+        const std::uint8_t *fileEnd = data + size;
+        while (pos + 8 <= fileEnd)
+        {
+            const std::uint8_t *chunkEnd = pos + 8 + read32(pos + 4);
+            if (chunkEnd > fileEnd) chunkEnd = fileEnd; // truncated file: keep what is there
+            if (matches(pos, "MTrk"))
+            {
+                tracks.emplace_back(pos + 8, chunkEnd);
+            }
+            pos = chunkEnd;
+        }
+    }
+
+    static bool matches(const std::uint8_t *p, const char *tag)
+    {
+        return p[0] == tag[0] && p[1] == tag[1] && p[2] == tag[2] && p[3] == tag[3];
+    }
+
+    static std::uint32_t read32(const std::uint8_t *p)
+    {
+        return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+    }
+
+    static int read16(const std::uint8_t *p)
+    {
+        return (p[0] << 8) | p[1];
+    }
+
+    const std::uint8_t *data;
+    size_t size;
+    int format;
+    int ticksPerBeat;
+    std::vector<std::pair<const std::uint8_t *, const std::uint8_t *>> tracks;
+};
+
+// PMidiNotes: one field of the notes of a mapped MIDI track as a Pattern.
+// Duration and Delta are in beats. A Track starts each note when the previous
+// one's duration has elapsed, so it only reproduces the file's timing with
+// Delta, the time to the next onset, as its durations pattern; notes then
+// sound until the next onset rather than for their own length, and notes of
+// a chord (Delta 0) are played a tick apart.
+class PMidiNotes : public Pattern
+{
+public:
+    enum class Field { Pitch, Velocity, Duration, Delta };
+
+    PMidiNotes(std::shared_ptr<const MidiFile> file, size_t track, Field field)
+        : file(file), reader(file->track(track)), field(field) {}
+
+    void reset() override
+    {
+        reader.reset();
+    }
+
+    void save(StateWriter &out) const override
+    {
+        out.tag("PMID");
+        reader.save(out);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PMID");
+        reader.load(in);
+    }
+
+    double next() override
+    {
+        MidiNote note;
+        if (!reader.next(note))
+            throw std::out_of_range("MIDI track exhausted");
+
+        switch (field)
+        {
+        case Field::Pitch:
+            return note.note;
+        case Field::Velocity:
+            return note.velocity;
+        case Field::Delta:
+            return static_cast<double>(reader.nextOnset() - note.tick) / file->getTicksPerBeat();
+        default:
+            return static_cast<double>(note.duration) / file->getTicksPerBeat();
+        }
+    }
+
+private:
+    std::shared_ptr<const MidiFile> file;
+    MidiTrackReader reader;
+    Field field;
+};
+
+#endif // MIDIREADER_H
@@ -0,0 +1,345 @@
+#ifndef MIDIWRITER_H
+#define MIDIWRITER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Time.h"
+#include "Timeline.h"
+
+// Streaming Standard MIDI File writer. Events are encoded straight into a
+// reusable output buffer that is flushed with one write() whenever it fills,
+// so a song is never held in memory. Chunk lengths are patched in place with
+// pwrite() when a track ends, which is why the output must be a regular file.
+//
+// Type 0 files hold a single track that is opened implicitly. For type 1, wrap
+// each track's events in beginTrack()/endTrack(); tracks are written one after
+// another, so feed them one at a time (see writeTrack()).
+class MidiWriter
+{
+public:
+    MidiWriter(const std::string &path, const TimeBase &timeBase, int format = 0, size_t bufferSize = 1 << 20)
+        : timeBase(timeBase), format(format), fd(-1), fileOffset(0), trackStart(-1),
+          numTracks(0), lastTick(0), runningStatus(0), totalBytes(0), totalEvents(0)
+    {
+        if (format != 0 && format != 1)
+            throw std::invalid_argument("Only SMF type 0 and 1 are supported");
+        if (timeBase.getTicksPerBeat() > 0x7fff)
+            throw std::invalid_argument("Ticks per beat does not fit in an SMF header");
+        if (timeBase.getMicrosPerBeat() > 0xffffff)
+            throw std::invalid_argument("Tempo is too slow for an SMF tempo event");
+
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw std::runtime_error("Could not open MIDI file for writing: " + path);
+
+        buffer.reserve(std::max<size_t>(bufferSize, 64));
+        pendingOffs.reserve(128);
+
+        // MThd; the track count is patched on close().
+        put("MThd", 4);
+        put32(6);
+        put16(static_cast<std::uint16_t>(format));
+        put16(0);
+        put16(static_cast<std::uint16_t>(timeBase.getTicksPerBeat()));
+    }
+
+    ~MidiWriter()
+    {
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    MidiWriter(const MidiWriter &) = delete;
+    MidiWriter &operator=(const MidiWriter &) = delete;
+
+    void beginTrack()
+    {
+        if (trackStart >= 0)
+            throw std::logic_error("Previous MIDI track has not been ended");
+        if (format == 0 && numTracks > 0)
+            throw std::logic_error("SMF type 0 holds a single track");
+
+        trackStart = fileOffset + static_cast<std::int64_t>(buffer.size());
+        put("MTrk", 4);
+        put32(0);
+        lastTick = 0;
+        runningStatus = 0;
+
+        if (numTracks == 0)
+        {
+            // Tempo meta event: FF 51 03 tttttt (microseconds per beat).
+            std::uint32_t tempo = static_cast<std::uint32_t>(timeBase.getMicrosPerBeat());
+            putDelta(0);
+            const std::uint8_t meta[] = {0xff, 0x51, 0x03,
+                                         static_cast<std::uint8_t>(tempo >> 16),
+                                         static_cast<std::uint8_t>(tempo >> 8),
+                                         static_cast<std::uint8_t>(tempo)};
+            put(meta, sizeof(meta));
+        }
+        numTracks++;
+    }
+
+    // Writes a note-on at event.tick and schedules its note-off at
+    // event.tick + event.duration. Ticks must not decrease within a track;
+    // events with zero velocity are rests and produce nothing.
+    void write(const Event &event)
+    {
+        if (trackStart < 0)
+        {
+            if (format != 0)
+                throw std::logic_error("beginTrack() must be called before writing to a type 1 file");
+            beginTrack();
+        }
+        if (event.tick < lastTick)
+            throw std::invalid_argument("MIDI events must be written in tick order");
+        if (event.velocity <= 0) return; // rest
+
+        flushNoteOffs(event.tick);
+        std::uint8_t channel = static_cast<std::uint8_t>(event.channel & 0x0f);
+        putMessage(event.tick, 0x90 | channel,
+                   static_cast<std::uint8_t>(event.note & 0x7f),
+                   static_cast<std::uint8_t>(std::min(event.velocity, 127)));
+        pendingOffs.push_back(NoteOff{event.tick + std::max<Tick>(0, event.duration), channel,
+                                      static_cast<std::uint8_t>(event.note & 0x7f)});
+        std::push_heap(pendingOffs.begin(), pendingOffs.end(), std::greater<NoteOff>());
+        totalEvents++;
+    }
+
+    void write(const std::vector<Event> &events)
+    {
+        for (const auto &event : events)
+        {
+            write(event);
+        }
+    }
+
+    // Releases every sounding note, writes End of Track and patches the length.
+    void endTrack()
+    {
+        if (trackStart < 0) return;
+
+        flushNoteOffs(std::numeric_limits<Tick>::max());
+        putDelta(0);
+        const std::uint8_t endOfTrack[] = {0xff, 0x2f, 0x00};
+        put(endOfTrack, sizeof(endOfTrack));
+
+        std::int64_t end = fileOffset + static_cast<std::int64_t>(buffer.size());
+        patch32(trackStart + 4, static_cast<std::uint32_t>(end - trackStart - 8));
+        trackStart = -1;
+    }
+
+    void close()
+    {
+        if (fd < 0) return;
+        endTrack();
+        flush();
+        std::uint8_t count[2] = {static_cast<std::uint8_t>(numTracks >> 8), static_cast<std::uint8_t>(numTracks)};
+        if (::pwrite(fd, count, 2, 10) != 2)
+            throw std::runtime_error("Failed to write MIDI header");
+        ::close(fd);
+        fd = -1;
+    }
+
+    // Bytes encoded so far (including still-buffered ones) and note events written.
+    std::uint64_t bytesWritten() const
+    {
+        return totalBytes;
+    }
+
+    std::uint64_t eventsWritten() const
+    {
+        return totalEvents;
+    }
+
+private:
+    static constexpr Tick MaxDelta = 0x0fffffff;
+
+    struct NoteOff
+    {
+        Tick tick;
+        std::uint8_t channel;
+        std::uint8_t note;
+
+        bool operator>(const NoteOff &other) const
+        {
+            return tick > other.tick;
+        }
+    };
+
+    void flushNoteOffs(Tick upTo)
+    {
+        while (!pendingOffs.empty() && pendingOffs.front().tick <= upTo)
+        {
+            std::pop_heap(pendingOffs.begin(), pendingOffs.end(), std::greater<NoteOff>());
+            NoteOff off = pendingOffs.back();
+            pendingOffs.pop_back();
+            // Note-on with velocity 0 keeps running status intact.
+            putMessage(off.tick, 0x90 | off.channel, off.note, 0);
+        }
+    }
+
+    void putMessage(Tick tick, std::uint8_t status, std::uint8_t data1, std::uint8_t data2)
+    {
+        putDelta(tick - lastTick);
+        lastTick = tick;
+        if (status != runningStatus)
+        {
+            putByte(status);
+            runningStatus = status;
+        }
+        putByte(data1);
+        putByte(data2);
+    }
+
+    // Delta-times hold at most 28 bits; a longer gap is bridged with empty
+    // text meta events (FF 01 00), which readers skip. A meta event cancels
+    // running status.
+    void putDelta(Tick delta)
+    {
+        while (delta > MaxDelta)
+        {
+            putVarLen(MaxDelta);
+            const std::uint8_t bridge[] = {0xff, 0x01, 0x00};
+            put(bridge, sizeof(bridge));
+            runningStatus = 0;
+            delta -= MaxDelta;
+        }
+        putVarLen(static_cast<std::uint32_t>(delta));
+    }
+
+    // Variable-length quantity, most significant group first.
+    void putVarLen(std::uint32_t value)
+    {
+        std::uint8_t bytes[4];
+        int n = 0;
+        bytes[n++] = value & 0x7f;
+        while (value >>= 7)
+        {
+            bytes[n++] = static_cast<std::uint8_t>((value & 0x7f) | 0x80);
+        }
+        reserve(n);
+        while (n > 0)
+        {
+            buffer.push_back(bytes[--n]);
+        }
+    }
+
+    void putByte(std::uint8_t value)
+    {
+        reserve(1);
+        buffer.push_back(value);
+    }
+
+    void put(const void *data, size_t size)
+    {
+        reserve(size);
+        const std::uint8_t *bytes = static_cast<const std::uint8_t *>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    void put16(std::uint16_t value)
+    {
+        const std::uint8_t bytes[] = {static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value)};
+        put(bytes, 2);
+    }
+
+    void put32(std::uint32_t value)
+    {
+        const std::uint8_t bytes[] = {static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+                                      static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value)};
+        put(bytes, 4);
+    }
+
+    // Writes a big-endian length either into the buffer or, if that part has
+    // already been flushed, directly into the file.
+    void patch32(std::int64_t offset, std::uint32_t value)
+    {
+        const std::uint8_t bytes[] = {static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+                                      static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value)};
+        if (offset >= fileOffset)
+        {
+            std::memcpy(buffer.data() + (offset - fileOffset), bytes, 4);
+        }
+        else if (::pwrite(fd, bytes, 4, offset) != 4)
+        {
+            throw std::runtime_error("Failed to patch MIDI chunk length");
+        }
+    }
+
+    void reserve(size_t size)
+    {
+        totalBytes += size;
+        if (buffer.size() + size > buffer.capacity()) flush();
+    }
+
+    void flush()
+    {
+        size_t done = 0;
+        while (done < buffer.size())
+        {
+            ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if (n < 0)
+                throw std::runtime_error("Failed to write MIDI file");
+            done += static_cast<size_t>(n);
+        }
+        fileOffset += static_cast<std::int64_t>(buffer.size());
+        buffer.clear();
+    }
+
+    TimeBase timeBase;
+    int format;
+    int fd;
+    std::int64_t fileOffset;  // file position of buffer[0]
+    std::int64_t trackStart;  // file position of the open MTrk, or -1
+    int numTracks;
+    Tick lastTick;
+    std::uint8_t runningStatus;
+    std::uint64_t totalBytes;
+    std::uint64_t totalEvents;
+    std::vector<std::uint8_t> buffer;
+    std::vector<NoteOff> pendingOffs; // min-heap on tick
+};
+
+// Streams a timeline's offline render into a type 0 file, blockTicks at a time.
+inline void renderToMidi(Timeline &timeline, Tick length, MidiWriter &writer, Tick blockTicks = 1920)
+{
+    std::vector<Event> block;
+    for (Tick done = 0; done < length; done += blockTicks)
+    {
+        block.clear();
+        timeline.render(std::min(blockTicks, length - done), block);
+        writer.write(block);
+    }
+}
+
+// Streams one track into its own chunk of a type 1 file.
+inline void writeTrack(Track &track, const TimeBase &timeBase, Tick length, MidiWriter &writer, Tick blockTicks = 1920)
+{
+    std::vector<Event> block;
+    writer.beginTrack();
+    for (Tick from = 0; from < length && !track.finished(); from += blockTicks)
+    {
+        block.clear();
+        track.render(from, std::min(length, from + blockTicks), timeBase, block);
+        writer.write(block);
+    }
+    writer.endTrack();
+}
+
+#endif // MIDIWRITER_H
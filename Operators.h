@@ -0,0 +1,391 @@
+#ifndef OPERATORS_H
+#define OPERATORS_H
+
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+#include "Pattern.h"
+#include "Key.h"
+
+// PAffine: clamp(source * mul + add, lo, hi). Any chain of scaling, offsets
+// and clamps is again of this form, so when a PAffine is built on top of
+// another the two are composed into one node over the inner source. However
+// long a chain of constant operations, evaluating it costs one call on the
+// source plus one branch-free loop over the block.
+class PAffine : public Pattern
+{
+public:
+    struct Map
+    {
+        double mul;
+        double add;
+        double lo;
+        double hi;
+
+        double operator()(double x) const
+        {
+            return std::min(std::max(x * mul + add, lo), hi);
+        }
+    };
+
+    static constexpr Map Identity{1, 0, -std::numeric_limits<double>::infinity(),
+                                  std::numeric_limits<double>::infinity()};
+
+    PAffine(std::shared_ptr<Pattern> pattern, double factor, double offset,
+            double lower = -std::numeric_limits<double>::infinity(),
+            double upper = std::numeric_limits<double>::infinity())
+        : source(std::move(pattern)), mul(1), add(0), lo(-std::numeric_limits<double>::infinity()),
+          hi(std::numeric_limits<double>::infinity())
+    {
+        if (auto inner = std::dynamic_pointer_cast<PAffine>(source))
+        {
+            source = inner->source;
+            mul = inner->mul;
+            add = inner->add;
+            lo = inner->lo;
+            hi = inner->hi;
+        }
+        then(factor, offset);
+        clamp(lower, upper);
+    }
+
+    void reset() override
+    {
+        source->reset();
+    }
+
+    double next() override
+    {
+        return getMap()(source->next());
+    }
+
+    size_t nextBlock(double *out, size_t count) override
+    {
+        size_t n = source->nextBlock(out, count);
+        const Map map = getMap();
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = map(out[i]);
+        }
+        return n;
+    }
+
+    const std::shared_ptr<Pattern> &getSource() const
+    {
+        return source;
+    }
+
+    Map getMap() const
+    {
+        return Map{mul, add, lo, hi};
+    }
+
+    size_t bufferBytes() const override
+    {
+        return source->bufferBytes();
+    }
+
+    void save(StateWriter &out) const override
+    {
+        out.tag("PAFF");
+        source->save(out);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PAFF");
+        source->load(in);
+    }
+
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PAFF");
+        out.write(mul);
+        out.write(add);
+        out.write(lo);
+        out.write(hi);
+        return source->signature(out);
+    }
+
+private:
+    // Applies x -> x * m + a after the current map.
+    void then(double m, double a)
+    {
+        mul *= m;
+        add = add * m + a;
+        if (m > 0)
+        {
+            lo = lo * m + a;
+            hi = hi * m + a;
+        }
+        else if (m < 0)
+        {
+            double newLo = hi * m + a;
+            hi = lo * m + a;
+            lo = newLo;
+        }
+        else
+        {
+            lo = -std::numeric_limits<double>::infinity();
+            hi = std::numeric_limits<double>::infinity();
+        }
+    }
+
+    // Applies x -> clamp(x, l, h) after the current map.
+    void clamp(double l, double h)
+    {
+        lo = std::min(std::max(lo, l), h);
+        hi = std::min(std::max(hi, l), h);
+    }
+
+    std::shared_ptr<Pattern> source;
+    double mul;
+    double add;
+    double lo;
+    double hi;
+};
+
+// PScale: maps [inLo, inHi] linearly onto [outLo, outHi] (without clamping).
+class PScale : public PAffine
+{
+public:
+    PScale(std::shared_ptr<Pattern> source, double inLo, double inHi, double outLo, double outHi)
+        : PAffine(std::move(source), (outHi - outLo) / (inHi - inLo), outLo - inLo * (outHi - outLo) / (inHi - inLo))
+    {
+        if (inHi == inLo)
+            throw std::invalid_argument("PScale input range must not be empty");
+    }
+};
+
+// PClamp: limits values to [lo, hi].
+class PClamp : public PAffine
+{
+public:
+    PClamp(std::shared_ptr<Pattern> source, double lo, double hi)
+        : PAffine(std::move(source), 1, 0, lo, hi)
+    {
+        if (lo > hi)
+            throw std::invalid_argument("PClamp lower bound must not exceed upper bound");
+    }
+};
+
+// PBinary: combines two patterns value by value; ends when either ends. An
+// operand that is a PAffine is read through its source, with its map applied
+// in the combining loop, so (notes * 2 + 1) + offsets is one pass over the
+// block after the two sources. An affine map on top of a PBinary is still a
+// pass of its own.
+template <typename Op>
+class PBinary : public Pattern
+{
+public:
+    PBinary(std::shared_ptr<Pattern> a, std::shared_ptr<Pattern> b)
+        : a(unwrap(std::move(a), mapA)), b(unwrap(std::move(b), mapB)) {}
+
+    void reset() override
+    {
+        a->reset();
+        b->reset();
+    }
+
+    double next() override
+    {
+        double x = mapA(a->next());
+        return Op()(x, mapB(b->next()));
+    }
+
+    size_t nextBlock(double *out, size_t count) override
+    {
+        if (scratch.size() < count) scratch.resize(count);
+        size_t n = a->nextBlock(out, count);
+        n = b->nextBlock(scratch.data(), n);
+        const double *rhs = scratch.data();
+        const PAffine::Map left = mapA, right = mapB;
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = Op()(left(out[i]), right(rhs[i]));
+        }
+        return n;
+    }
+
+    size_t bufferBytes() const override
+    {
+        return a->bufferBytes() + b->bufferBytes() + scratch.capacity() * sizeof(double);
+    }
+
+    void save(StateWriter &out) const override
+    {
+        out.tag("PBIN");
+        a->save(out);
+        b->save(out);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PBIN");
+        a->load(in);
+        b->load(in);
+    }
+
+    // Signatures only live in memory, so the operator is told apart by its
+    // type's hash code.
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PBIN");
+        out.write(typeid(Op).hash_code());
+        out.write(mapA);
+        out.write(mapB);
+        return a->signature(out) && b->signature(out);
+    }
+
+private:
+    static std::shared_ptr<Pattern> unwrap(std::shared_ptr<Pattern> operand, PAffine::Map &map)
+    {
+        if (auto affine = std::dynamic_pointer_cast<PAffine>(operand))
+        {
+            map = affine->getMap();
+            return affine->getSource();
+        }
+        map = PAffine::Identity;
+        return operand;
+    }
+
+    PAffine::Map mapA;
+    PAffine::Map mapB;
+    std::shared_ptr<Pattern> a;
+    std::shared_ptr<Pattern> b;
+    std::vector<double> scratch;
+};
+
+using PAdd = PBinary<std::plus<double>>;
+using PSub = PBinary<std::minus<double>>;
+using PMul = PBinary<std::multiplies<double>>;
+using PDiv = PBinary<std::divides<double>>;
+
+// PDegree: reads scale degrees and yields the notes of key; -1 stays a rest.
+class PDegree : public Pattern
+{
+public:
+    PDegree(std::shared_ptr<Pattern> degrees, const Key &key) : degrees(std::move(degrees)), key(key) {}
+
+    void reset() override
+    {
+        degrees->reset();
+    }
+
+    double next() override
+    {
+        return key.get(static_cast<int>(degrees->next()));
+    }
+
+    size_t nextBlock(double *out, size_t count) override
+    {
+        size_t n = degrees->nextBlock(out, count);
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = key.get(static_cast<int>(out[i]));
+        }
+        return n;
+    }
+
+    void save(StateWriter &out) const override
+    {
+        out.tag("PDEG");
+        degrees->save(out);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PDEG");
+        degrees->load(in);
+    }
+
+private:
+    std::shared_ptr<Pattern> degrees;
+    Key key;
+};
+
+// Arithmetic on pattern pointers, e.g. (notes * 2 + 60) or (a + b). Operations
+// with a constant build (and so fold into) a PAffine. The templates only accept
+// pointers to Pattern types, so they stay out of overload resolution for any
+// other shared_ptr.
+template <typename P>
+concept PatternType = std::derived_from<P, Pattern>;
+
+template <PatternType A, PatternType B>
+std::shared_ptr<Pattern> operator+(const std::shared_ptr<A> &a, const std::shared_ptr<B> &b)
+{
+    return std::make_shared<PAdd>(a, b);
+}
+
+template <PatternType A, PatternType B>
+std::shared_ptr<Pattern> operator-(const std::shared_ptr<A> &a, const std::shared_ptr<B> &b)
+{
+    return std::make_shared<PSub>(a, b);
+}
+
+template <PatternType A, PatternType B>
+std::shared_ptr<Pattern> operator*(const std::shared_ptr<A> &a, const std::shared_ptr<B> &b)
+{
+    return std::make_shared<PMul>(a, b);
+}
+
+template <PatternType A, PatternType B>
+std::shared_ptr<Pattern> operator/(const std::shared_ptr<A> &a, const std::shared_ptr<B> &b)
+{
+    return std::make_shared<PDiv>(a, b);
+}
+
+template <PatternType A>
+std::shared_ptr<Pattern> operator+(const std::shared_ptr<A> &a, double b)
+{
+    return std::make_shared<PAffine>(a, 1, b);
+}
+
+template <PatternType A>
+std::shared_ptr<Pattern> operator+(double a, const std::shared_ptr<A> &b)
+{
+    return std::make_shared<PAffine>(b, 1, a);
+}
+
+template <PatternType A>
+std::shared_ptr<Pattern> operator-(const std::shared_ptr<A> &a, double b)
+{
+    return std::make_shared<PAffine>(a, 1, -b);
+}
+
+template <PatternType A>
+std::shared_ptr<Pattern> operator-(double a, const std::shared_ptr<A> &b)
+{
+    return std::make_shared<PAffine>(b, -1, a);
+}
+
+template <PatternType A>
+std::shared_ptr<Pattern> operator-(const std::shared_ptr<A> &a)
+{
+    return std::make_shared<PAffine>(a, -1, 0);
+}
+
+template <PatternType A>
+std::shared_ptr<Pattern> operator*(const std::shared_ptr<A> &a, double b)
+{
+    return std::make_shared<PAffine>(a, b, 0);
+}
+
+template <PatternType A>
+std::shared_ptr<Pattern> operator*(double a, const std::shared_ptr<A> &b)
+{
+    return std::make_shared<PAffine>(b, a, 0);
+}
+
+template <PatternType A>
+std::shared_ptr<Pattern> operator/(const std::shared_ptr<A> &a, double b)
+{
+    return std::make_shared<PAffine>(a, 1 / b, 0);
+}
+
+#endif // OPERATORS_H
@@ -0,0 +1,400 @@
+#ifndef OSC_H
+#define OSC_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Timeline.h"
+#include "RingBuffer.h"
+
+namespace osc
+{
+// OSC time tags are NTP timestamps: seconds since 1900 plus a 32-bit fraction.
+inline std::uint64_t timeTag(std::chrono::system_clock::time_point time)
+{
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    std::uint64_t seconds = static_cast<std::uint64_t>(nanos / 1000000000) + 2208988800ULL;
+    std::uint64_t fraction = (static_cast<std::uint64_t>(nanos % 1000000000) << 32) / 1000000000;
+    return (seconds << 32) | fraction;
+}
+
+inline std::chrono::system_clock::time_point fromTimeTag(std::uint64_t tag)
+{
+    std::int64_t seconds = static_cast<std::int64_t>(tag >> 32) - 2208988800LL;
+    std::int64_t nanos = static_cast<std::int64_t>(((tag & 0xffffffffULL) * 1000000000) >> 32);
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(seconds * 1000000000 + nanos)));
+}
+
+inline void put32(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    out.push_back(static_cast<std::uint8_t>(value >> 24));
+    out.push_back(static_cast<std::uint8_t>(value >> 16));
+    out.push_back(static_cast<std::uint8_t>(value >> 8));
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+// Null-terminated and padded to a multiple of four bytes.
+inline void putString(std::vector<std::uint8_t> &out, const std::string &value)
+{
+    out.insert(out.end(), value.begin(), value.end());
+    size_t padding = 4 - value.size() % 4;
+    out.insert(out.end(), padding, 0);
+}
+
+inline std::uint32_t read32(const std::uint8_t *p)
+{
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+}
+} // namespace osc
+
+// Sends timeline events as OSC bundles over UDP. Each event becomes a message
+// "<address> ,iiiii track channel note velocity duration"; all events of one
+// tick share a bundle, and every bundle ready when the sender wakes goes out in
+// a single sendmmsg() call. send() only pushes onto a lock-free ring, so the
+// clock thread never blocks; if the ring is full the event is dropped and
+// counted. send() must be called from one thread at a time.
+class OscOutput
+{
+public:
+    OscOutput(const std::string &host, int port, const std::string &address = "/isobar/note",
+              size_t capacity = 8192, size_t maxDatagram = 1400)
+        : address(address), maxDatagram(maxDatagram), queue(capacity), running(true),
+          dropped(0), bundlesSent(0), datagramCalls(0), latency(0)
+    {
+        socketFd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (socketFd < 0)
+            throw std::runtime_error("Could not create UDP socket");
+
+        std::memset(&destination, 0, sizeof(destination));
+        destination.sin_family = AF_INET;
+        destination.sin_port = htons(static_cast<std::uint16_t>(port));
+        if (::inet_pton(AF_INET, host.c_str(), &destination.sin_addr) != 1)
+        {
+            ::close(socketFd);
+            throw std::invalid_argument("Invalid IPv4 address: " + host);
+        }
+
+        sender = std::thread(&OscOutput::run, this);
+    }
+
+    ~OscOutput()
+    {
+        running = false;
+        sender.join();
+        ::close(socketFd);
+    }
+
+    OscOutput(const OscOutput &) = delete;
+    OscOutput &operator=(const OscOutput &) = delete;
+
+    // Real-time safe; suitable as a Timeline output.
+    void send(const Event &event)
+    {
+        if (!queue.push(Queued{event, std::chrono::system_clock::now()}))
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            ISOBAR_TRACE_ERROR("osc queue full, event dropped", event);
+        }
+    }
+
+    // Bundles are time-tagged this far ahead of the moment their events were
+    // queued, so receivers can schedule them precisely. Zero sends them tagged
+    // with the queue time, which lets a receiver measure end-to-end latency.
+    void setLatency(std::chrono::microseconds newLatency)
+    {
+        latency.store(newLatency.count(), std::memory_order_relaxed);
+    }
+
+    unsigned long getDropped() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    unsigned long getBundlesSent() const
+    {
+        return bundlesSent.load(std::memory_order_relaxed);
+    }
+
+    // Number of sendmmsg() calls; bundlesSent / sendCalls is the batching factor.
+    unsigned long getSendCalls() const
+    {
+        return datagramCalls.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Queued
+    {
+        Event event;
+        std::chrono::system_clock::time_point queued;
+    };
+
+    void run()
+    {
+        const auto idle = std::chrono::microseconds(250);
+        while (running || queue.size() > 0)
+        {
+            if (queue.size() == 0)
+            {
+                std::this_thread::sleep_for(idle);
+                continue;
+            }
+            encodeAvailable();
+            flush();
+        }
+    }
+
+    // Packs everything currently queued into bundles, one per tick (split if a
+    // tick does not fit in one datagram).
+    void encodeAvailable()
+    {
+        datagrams.clear();
+        Queued item;
+        Tick bundleTick = -1;
+        while (const Queued *next = queue.front())
+        {
+            item = *next;
+            queue.discard();
+
+            if (datagrams.empty() || item.event.tick != bundleTick ||
+                datagrams.back().size() + messageSize() > maxDatagram)
+            {
+                beginBundle(item);
+                bundleTick = item.event.tick;
+            }
+            appendMessage(datagrams.back(), item.event);
+        }
+    }
+
+    void beginBundle(const Queued &item)
+    {
+        datagrams.emplace_back();
+        auto &out = datagrams.back();
+        out.reserve(maxDatagram);
+        osc::putString(out, "#bundle");
+        std::uint64_t tag = osc::timeTag(item.queued + std::chrono::microseconds(latency.load(std::memory_order_relaxed)));
+        osc::put32(out, static_cast<std::uint32_t>(tag >> 32));
+        osc::put32(out, static_cast<std::uint32_t>(tag));
+    }
+
+    size_t messageSize() const
+    {
+        return 4 + (address.size() / 4 + 1) * 4 + 8 + 5 * 4;
+    }
+
+    void appendMessage(std::vector<std::uint8_t> &out, const Event &event)
+    {
+        size_t sizePos = out.size();
+        osc::put32(out, 0);
+        osc::putString(out, address);
+        osc::putString(out, ",iiiii");
+        osc::put32(out, static_cast<std::uint32_t>(event.track));
+        osc::put32(out, static_cast<std::uint32_t>(event.channel));
+        osc::put32(out, static_cast<std::uint32_t>(event.note));
+        osc::put32(out, static_cast<std::uint32_t>(event.velocity));
+        osc::put32(out, static_cast<std::uint32_t>(event.duration));
+        std::uint32_t size = static_cast<std::uint32_t>(out.size() - sizePos - 4);
+        out[sizePos] = static_cast<std::uint8_t>(size >> 24);
+        out[sizePos + 1] = static_cast<std::uint8_t>(size >> 16);
+        out[sizePos + 2] = static_cast<std::uint8_t>(size >> 8);
+        out[sizePos + 3] = static_cast<std::uint8_t>(size);
+    }
+
+    void flush()
+    {
+        if (datagrams.empty()) return;
+#ifdef __linux__
+        iovecs.resize(datagrams.size());
+        headers.resize(datagrams.size());
+        for (size_t i = 0; i < datagrams.size(); ++i)
+        {
+            iovecs[i].iov_base = datagrams[i].data();
+            iovecs[i].iov_len = datagrams[i].size();
+            std::memset(&headers[i], 0, sizeof(headers[i]));
+            headers[i].msg_hdr.msg_name = &destination;
+            headers[i].msg_hdr.msg_namelen = sizeof(destination);
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        size_t sent = 0;
+        while (sent < headers.size())
+        {
+            int n = ::sendmmsg(socketFd, headers.data() + sent, static_cast<unsigned>(headers.size() - sent), 0);
+            datagramCalls.fetch_add(1, std::memory_order_relaxed);
+            if (n <= 0) break; // UDP is lossy anyway; don't stall the sender
+            sent += static_cast<size_t>(n);
+        }
+        bundlesSent.fetch_add(sent, std::memory_order_relaxed);
+#else
+        for (auto &datagram : datagrams)
+        {
+            ::sendto(socketFd, datagram.data(), datagram.size(), 0,
+                     reinterpret_cast<const sockaddr *>(&destination), sizeof(destination));
+            datagramCalls.fetch_add(1, std::memory_order_relaxed);
+        }
+        bundlesSent.fetch_add(datagrams.size(), std::memory_order_relaxed);
+#endif
+    }
+
+    std::string address;
+    size_t maxDatagram;
+    int socketFd;
+    sockaddr_in destination;
+    RingBuffer<Queued> queue;
+    std::thread sender;
+    std::atomic<bool> running;
+    std::atomic<unsigned long> dropped;
+    std::atomic<unsigned long> bundlesSent;
+    std::atomic<unsigned long> datagramCalls;
+    std::atomic<long long> latency;
+    std::vector<std::vector<std::uint8_t>> datagrams;
+#ifdef __linux__
+    std::vector<iovec> iovecs;
+    std::vector<mmsghdr> headers;
+#endif
+};
+
+// A note message as received by OscReceiver.
+struct OscNote
+{
+    Event event;
+    std::chrono::nanoseconds latency; // arrival time minus the bundle's time tag
+};
+
+// Loopback receiver for tests and latency measurement: listens on 127.0.0.1
+// and decodes the bundles OscOutput sends.
+class OscReceiver
+{
+public:
+    explicit OscReceiver(int port = 0)
+        : running(true), bundles(0)
+    {
+        socketFd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (socketFd < 0)
+            throw std::runtime_error("Could not create UDP socket");
+
+        sockaddr_in local;
+        std::memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(static_cast<std::uint16_t>(port));
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(local);
+        if (::bind(socketFd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0 ||
+            ::getsockname(socketFd, reinterpret_cast<sockaddr *>(&local), &length) != 0)
+        {
+            ::close(socketFd);
+            throw std::runtime_error("Could not bind UDP socket");
+        }
+        boundPort = ntohs(local.sin_port);
+
+        timeval timeout{0, 20000};
+        ::setsockopt(socketFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        receiver = std::thread(&OscReceiver::run, this);
+    }
+
+    ~OscReceiver()
+    {
+        running = false;
+        receiver.join();
+        ::close(socketFd);
+    }
+
+    int getPort() const
+    {
+        return boundPort;
+    }
+
+    // Waits until at least count notes have arrived or the timeout passes.
+    std::vector<OscNote> waitFor(size_t count, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        arrived.wait_for(lock, timeout, [&]() { return notes.size() >= count; });
+        return notes;
+    }
+
+    unsigned long getBundles() const
+    {
+        return bundles.load(std::memory_order_relaxed);
+    }
+
+private:
+    void run()
+    {
+        std::vector<std::uint8_t> buffer(65536);
+        while (running)
+        {
+            ssize_t n = ::recv(socketFd, buffer.data(), buffer.size(), 0);
+            if (n <= 0) continue;
+            auto now = std::chrono::system_clock::now();
+            parseBundle(buffer.data(), static_cast<size_t>(n), now);
+        }
+    }
+
+    void parseBundle(const std::uint8_t *data, size_t size, std::chrono::system_clock::time_point now)
+    {
+        if (size < 16 || std::memcmp(data, "#bundle", 8) != 0) return;
+        std::uint64_t tag = (std::uint64_t(osc::read32(data + 8)) << 32) | osc::read32(data + 12);
+        auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(now - osc::fromTimeTag(tag));
+
+        std::vector<OscNote> decoded;
+        size_t pos = 16;
+        while (pos + 4 <= size)
+        {
+            size_t length = osc::read32(data + pos);
+            pos += 4;
+            if (pos + length > size) break;
+            const std::uint8_t *message = data + pos;
+            pos += length;
+
+            // Skip the address and type tag strings, then read five int32 args.
+            size_t offset = 0;
+            for (int s = 0; s < 2; ++s)
+            {
+                while (offset < length && message[offset] != 0) offset++;
+                offset = (offset / 4 + 1) * 4;
+            }
+            if (offset + 20 > length) continue;
+
+            Event event;
+            event.tick = 0;
+            event.track = static_cast<int>(osc::read32(message + offset));
+            event.channel = static_cast<int>(osc::read32(message + offset + 4));
+            event.note = static_cast<int>(osc::read32(message + offset + 8));
+            event.velocity = static_cast<int>(osc::read32(message + offset + 12));
+            event.duration = static_cast<Tick>(static_cast<std::int32_t>(osc::read32(message + offset + 16)));
+            decoded.push_back(OscNote{event, latency});
+        }
+
+        bundles.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            notes.insert(notes.end(), decoded.begin(), decoded.end());
+        }
+        arrived.notify_all();
+    }
+
+    int socketFd;
+    int boundPort;
+    std::thread receiver;
+    std::atomic<bool> running;
+    std::atomic<unsigned long> bundles;
+    std::mutex mutex;
+    std::condition_variable arrived;
+    std::vector<OscNote> notes;
+};
+
+#endif // OSC_H
@@ -6,12 +6,82 @@
 #include <limits>
 #include <memory>
 
+#include "State.h"
+
 class Pattern
 {
 public:
     virtual ~Pattern() = default;
     virtual void reset() = 0;
     virtual double next() = 0;
+
+    // Writes up to count values to out and returns how many were written;
+    // fewer than count means the pattern ran out.
+    virtual size_t nextBlock(double *out, size_t count)
+    {
+        size_t n = 0;
+        try
+        {
+            for (; n < count; ++n) out[n] = next();
+        }
+        catch (const std::out_of_range &)
+        {
+        }
+        return n;
+    }
+
+    // Heap memory held for replay or lookahead (e.g. PLoop's recorded values).
+    virtual size_t bufferBytes() const
+    {
+        return 0;
+    }
+
+    // Writes the runtime state (not the structure) of this pattern and the
+    // patterns it reads from; load() restores it into an identically built graph.
+    virtual void save(StateWriter &) const
+    {
+        throw std::logic_error("Pattern does not support snapshots");
+    }
+
+    virtual void load(StateReader &)
+    {
+        throw std::logic_error("Pattern does not support snapshots");
+    }
+
+    // Writes the pattern's type, parameters and sources such that two patterns
+    // with equal signatures yield the same values from reset(). Returns false
+    // for patterns whose output cannot be described this way.
+    virtual bool signature(StateWriter &) const
+    {
+        return false;
+    }
 };
 
+inline Snapshot saveState(const Pattern &pattern)
+{
+    StateWriter out;
+    pattern.save(out);
+    return out.take();
+}
+
+// Loads are all or nothing: patterns restore in place, so the graph's current
+// state is saved first and put back if the snapshot turns out not to fit.
+inline void loadState(Pattern &pattern, std::span<const std::uint8_t> snapshot)
+{
+    Snapshot backup = saveState(pattern);
+    try
+    {
+        StateReader in(snapshot);
+        pattern.load(in);
+        if (in.remaining())
+            throw std::runtime_error("Snapshot does not match graph: trailing data");
+    }
+    catch (...)
+    {
+        StateReader undo(backup);
+        pattern.load(undo);
+        throw;
+    }
+}
+
 #endif // PATTERN_H
\ No newline at end of file
@@ -0,0 +1,250 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Pattern.h"
+
+// Pattern graph profiling. Wrap nodes with ISOBAR_PROFILE_PATTERN(name, pattern)
+// when building a graph; unless ISOBAR_PROFILE is defined to 1 the macro yields
+// the pattern itself, so there is no wrapper and no cost in normal builds.
+#ifndef ISOBAR_PROFILE
+#define ISOBAR_PROFILE 0
+#endif
+
+// Counters for one profiled node. parent is the first profiled node seen
+// calling it; a node shared between several callers is listed under that one.
+// calls counts next() and nextBlock() calls alike.
+struct ProfileNode
+{
+    std::string name;
+    ProfileNode *parent = nullptr;
+    std::vector<std::shared_ptr<ProfileNode>> children;
+    std::uint64_t calls = 0;
+    std::uint64_t totalNanos = 0; // including profiled children
+    std::uint64_t childNanos = 0;
+    std::uint64_t exhaustions = 0;
+    std::uint64_t resets = 0;
+    std::uint64_t bufferGrowths = 0;
+    size_t bufferBytes = 0;
+
+    std::uint64_t selfNanos() const
+    {
+        return totalNanos > childNanos ? totalNanos - childNanos : 0;
+    }
+};
+
+// Registry of profiled nodes and the call tree between them. Counters are
+// plain integers: a pattern graph is only ever driven by one thread at a time.
+class Profiler
+{
+public:
+    static Profiler &instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    std::shared_ptr<ProfileNode> add(const std::string &name)
+    {
+        auto node = std::make_shared<ProfileNode>();
+        node->name = name;
+        std::lock_guard<std::mutex> lock(mutex);
+        roots.push_back(node);
+        return node;
+    }
+
+    // Called the first time child runs inside parent; moves it under parent.
+    void link(ProfileNode *parent, ProfileNode *child)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (child->parent) return;
+        for (auto it = roots.begin(); it != roots.end(); ++it)
+        {
+            if (it->get() == child)
+            {
+                child->parent = parent;
+                parent->children.push_back(*it);
+                roots.erase(it);
+                return;
+            }
+        }
+    }
+
+    // Forgets every node recorded so far.
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        roots.clear();
+    }
+
+    // Indented tree, one node per line with its counters.
+    void printTree(std::ostream &out) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &root : roots) printNode(out, *root, 0);
+    }
+
+    // Collapsed stacks ("a;b;c <self ns>"), the input format of flamegraph.pl
+    // and speedscope.
+    void writeFolded(std::ostream &out) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &root : roots) foldNode(out, *root, "");
+    }
+
+    // Innermost profiled node running on this thread.
+    static ProfileNode *&current()
+    {
+        thread_local ProfileNode *node = nullptr;
+        return node;
+    }
+
+private:
+    Profiler() = default;
+
+    static void printNode(std::ostream &out, const ProfileNode &node, int depth)
+    {
+        out << std::string(depth * 2, ' ') << node.name << " calls=" << node.calls
+            << " total_us=" << node.totalNanos / 1000 << " self_us=" << node.selfNanos() / 1000;
+        if (node.exhaustions) out << " exhausted=" << node.exhaustions;
+        if (node.resets) out << " resets=" << node.resets;
+        if (node.bufferBytes) out << " buffer=" << node.bufferBytes << "B grew=" << node.bufferGrowths;
+        out << "\n";
+        for (const auto &child : node.children) printNode(out, *child, depth + 1);
+    }
+
+    static void foldNode(std::ostream &out, const ProfileNode &node, const std::string &prefix)
+    {
+        std::string stack = prefix.empty() ? node.name : prefix + ";" + node.name;
+        out << stack << " " << node.selfNanos() << "\n";
+        for (const auto &child : node.children) foldNode(out, *child, stack);
+    }
+
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<ProfileNode>> roots;
+};
+
+// PProfile: passes through another pattern, counting calls, time, resets,
+// exhaustion and growth of the pattern's internal buffer.
+class PProfile : public Pattern
+{
+public:
+    PProfile(const std::string &name, std::shared_ptr<Pattern> pattern)
+        : pattern(pattern), node(Profiler::instance().add(name)) {}
+
+    void reset() override
+    {
+        node->resets++;
+        pattern->reset();
+    }
+
+    double next() override
+    {
+        Scope scope(*node);
+        try
+        {
+            double value = pattern->next();
+            trackBuffer();
+            return value;
+        }
+        catch (const std::out_of_range &)
+        {
+            node->exhaustions++;
+            throw;
+        }
+    }
+
+    // Forwarded, so profiling keeps the wrapped pattern on its block path;
+    // a block counts as one call.
+    size_t nextBlock(double *out, size_t count) override
+    {
+        Scope scope(*node);
+        size_t n = pattern->nextBlock(out, count);
+        if (n < count) node->exhaustions++;
+        trackBuffer();
+        return n;
+    }
+
+    size_t bufferBytes() const override
+    {
+        return pattern->bufferBytes();
+    }
+
+    // Transparent, so snapshots move between profiled and plain builds.
+    void save(StateWriter &out) const override
+    {
+        pattern->save(out);
+    }
+
+    void load(StateReader &in) override
+    {
+        pattern->load(in);
+    }
+
+    // Transparent too, so a profiled subgraph still interns in a BlockCache.
+    bool signature(StateWriter &out) const override
+    {
+        return pattern->signature(out);
+    }
+
+    const ProfileNode &stats() const
+    {
+        return *node;
+    }
+
+private:
+    void trackBuffer()
+    {
+        size_t bytes = pattern->bufferBytes();
+        if (bytes > node->bufferBytes)
+        {
+            node->bufferGrowths++;
+            node->bufferBytes = bytes;
+        }
+    }
+
+    // Times one call and keeps the thread's stack of profiled nodes, so time
+    // spent in profiled children is not counted as this node's own.
+    struct Scope
+    {
+        explicit Scope(ProfileNode &node)
+            : node(node), caller(Profiler::current()), begin(std::chrono::steady_clock::now())
+        {
+            if (caller && !node.parent) Profiler::instance().link(caller, &node);
+            Profiler::current() = &node;
+        }
+
+        ~Scope()
+        {
+            auto nanos = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+            node.calls++;
+            node.totalNanos += nanos;
+            if (caller) caller->childNanos += nanos;
+            Profiler::current() = caller;
+        }
+
+        ProfileNode &node;
+        ProfileNode *caller;
+        std::chrono::steady_clock::time_point begin;
+    };
+
+    std::shared_ptr<Pattern> pattern;
+    std::shared_ptr<ProfileNode> node;
+};
+
+#if ISOBAR_PROFILE
+#define ISOBAR_PROFILE_PATTERN(name, pattern) std::shared_ptr<Pattern>(std::make_shared<PProfile>(name, pattern))
+#else
+#define ISOBAR_PROFILE_PATTERN(name, pattern) (pattern)
+#endif
+
+#endif // PROFILE_H
@@ -0,0 +1,309 @@
+#ifndef RHYTHM_H
+#define RHYTHM_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Pattern.h"
+
+// A cyclic rhythm of `steps` steps stored as an onset bitmask, bit i of word
+// i / 64 set for a hit on step i. Combinations are word-wide bit operations
+// and onset queries use popcount / count-trailing-zeros, so finding the next
+// hit costs one instruction per 64 empty steps rather than one call per step.
+class RhythmMask
+{
+public:
+    explicit RhythmMask(int steps = 16) : steps(steps), words((std::max(steps, 1) + 63) / 64, 0)
+    {
+        if (steps <= 0)
+            throw std::invalid_argument("Rhythm must have at least one step");
+    }
+
+    // "x..x..x." style: 'x' or 'X' is a hit, anything else a rest.
+    static RhythmMask fromString(const std::string &pattern)
+    {
+        RhythmMask mask(static_cast<int>(pattern.size()));
+        for (int i = 0; i < mask.steps; ++i)
+        {
+            if (pattern[i] == 'x' || pattern[i] == 'X') mask.set(i);
+        }
+        return mask;
+    }
+
+    // hits onsets spread as evenly as possible over steps (Bjorklund's
+    // rhythms up to rotation), starting on a hit.
+    static RhythmMask euclidean(int hits, int steps, int rotation = 0)
+    {
+        if (hits < 0 || hits > steps)
+            throw std::invalid_argument("Euclidean rhythm needs 0 <= hits <= steps");
+        RhythmMask mask(steps);
+        for (int i = 0; i < steps; ++i)
+        {
+            if (static_cast<std::int64_t>(i) * hits % steps < hits) mask.set(i);
+        }
+        return rotation ? mask.rotated(rotation) : mask;
+    }
+
+    // The most even rhythm with round(density * steps) hits.
+    static RhythmMask withDensity(int steps, double density)
+    {
+        int hits = static_cast<int>(std::lround(std::min(std::max(density, 0.0), 1.0) * steps));
+        return euclidean(hits, steps);
+    }
+
+    int length() const
+    {
+        return steps;
+    }
+
+    bool hit(int step) const
+    {
+        return (words[step >> 6] >> (step & 63)) & 1;
+    }
+
+    void set(int step, bool on = true)
+    {
+        std::uint64_t bit = std::uint64_t(1) << (step & 63);
+        if (on)
+            words[step >> 6] |= bit;
+        else
+            words[step >> 6] &= ~bit;
+    }
+
+    int count() const
+    {
+        int total = 0;
+        for (std::uint64_t word : words) total += std::popcount(word);
+        return total;
+    }
+
+    double density() const
+    {
+        return static_cast<double>(count()) / steps;
+    }
+
+    // First hit at or after step from, wrapping around; -1 if there is none.
+    int nextOnset(int from) const
+    {
+        int index = from >> 6;
+        std::uint64_t word = words[index] >> (from & 63);
+        if (word) return from + std::countr_zero(word);
+        for (size_t i = 1; i <= words.size(); ++i)
+        {
+            size_t w = (index + i) % words.size();
+            if (words[w]) return static_cast<int>(w * 64) + std::countr_zero(words[w]);
+        }
+        return -1;
+    }
+
+    // Steps from `from` to the next hit (0 if from is a hit), wrapping; -1 if empty.
+    int stepsToOnset(int from) const
+    {
+        int onset = nextOnset(from);
+        if (onset < 0) return -1;
+        return onset >= from ? onset - from : onset + steps - from;
+    }
+
+    // Step i of the result is step i + shift of this mask: positive shifts
+    // move the rhythm earlier.
+    RhythmMask rotated(int shift) const
+    {
+        shift = ((shift % steps) + steps) % steps;
+        if (shift == 0) return *this;
+        RhythmMask result(steps);
+        if (steps <= 64)
+        {
+            std::uint64_t word = words[0];
+            result.words[0] = ((word >> shift) | (word << (steps - shift))) & lastWordMask();
+            return result;
+        }
+        forEachOnset([&](int step) { result.set((step - shift + steps) % steps); });
+        return result;
+    }
+
+    // The rhythm repeated (or cut) to newLength steps.
+    RhythmMask tiled(int newLength) const
+    {
+        RhythmMask result(newLength);
+        for (int start = 0; start < newLength; start += steps)
+        {
+            forEachOnset([&](int step)
+            {
+                if (start + step < newLength) result.set(start + step);
+            });
+        }
+        return result;
+    }
+
+    RhythmMask operator&(const RhythmMask &other) const
+    {
+        return combine(other, [](std::uint64_t a, std::uint64_t b) { return a & b; });
+    }
+
+    RhythmMask operator|(const RhythmMask &other) const
+    {
+        return combine(other, [](std::uint64_t a, std::uint64_t b) { return a | b; });
+    }
+
+    RhythmMask operator^(const RhythmMask &other) const
+    {
+        return combine(other, [](std::uint64_t a, std::uint64_t b) { return a ^ b; });
+    }
+
+    RhythmMask operator~() const
+    {
+        RhythmMask result(steps);
+        for (size_t i = 0; i < words.size(); ++i) result.words[i] = ~words[i];
+        result.words.back() &= lastWordMask();
+        return result;
+    }
+
+    bool operator==(const RhythmMask &other) const
+    {
+        return steps == other.steps && words == other.words;
+    }
+
+    std::string toString() const
+    {
+        std::string result(steps, '.');
+        forEachOnset([&](int step) { result[step] = 'x'; });
+        return result;
+    }
+
+    const std::vector<std::uint64_t> &getWords() const
+    {
+        return words;
+    }
+
+    template <typename Body>
+    void forEachOnset(Body body) const
+    {
+        for (size_t w = 0; w < words.size(); ++w)
+        {
+            for (std::uint64_t word = words[w]; word; word &= word - 1)
+            {
+                body(static_cast<int>(w * 64) + std::countr_zero(word));
+            }
+        }
+    }
+
+private:
+    std::uint64_t lastWordMask() const
+    {
+        int bits = steps - static_cast<int>(words.size() - 1) * 64;
+        return bits == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << bits) - 1;
+    }
+
+    // Rhythms of different lengths are combined over their common cycle, so
+    // a 3-step and a 4-step rhythm give a 12-step polyrhythm.
+    template <typename Op>
+    RhythmMask combine(const RhythmMask &other, Op op) const
+    {
+        if (steps != other.steps)
+        {
+            int cycle = std::lcm(steps, other.steps);
+            return tiled(cycle).combine(other.tiled(cycle), op);
+        }
+        RhythmMask result(steps);
+        for (size_t i = 0; i < words.size(); ++i) result.words[i] = op(words[i], other.words[i]);
+        result.words.back() &= lastWordMask();
+        return result;
+    }
+
+    int steps;
+    std::vector<std::uint64_t> words;
+};
+
+// PRhythm: loops a RhythmMask, yielding 1 on hits and 0 on rests.
+class PRhythm : public Pattern
+{
+public:
+    explicit PRhythm(const RhythmMask &mask) : mask(mask), pos(0) {}
+
+    void reset() override
+    {
+        pos = 0;
+    }
+
+    double next() override
+    {
+        double value = mask.hit(pos);
+        if (++pos == mask.length()) pos = 0;
+        return value;
+    }
+
+    // Unpacks up to 64 steps per word read.
+    size_t nextBlock(double *out, size_t count) override
+    {
+        const auto &words = mask.getWords();
+        size_t n = 0;
+        while (n < count)
+        {
+            int run = static_cast<int>(std::min<size_t>(count - n, 64 - (pos & 63)));
+            run = std::min(run, mask.length() - pos);
+            std::uint64_t word = words[pos >> 6] >> (pos & 63);
+            for (int j = 0; j < run; ++j)
+            {
+                out[n + j] = static_cast<double>((word >> j) & 1);
+            }
+            n += run;
+            pos += run;
+            if (pos == mask.length()) pos = 0;
+        }
+        return n;
+    }
+
+    // Rests before the next hit (0 if the next step is a hit); -1 if the mask is empty.
+    int stepsToOnset() const
+    {
+        return mask.stepsToOnset(pos);
+    }
+
+    // Skips the rests before the next hit and returns how many there were;
+    // the following next() returns that hit.
+    int skipToOnset()
+    {
+        int skipped = stepsToOnset();
+        if (skipped > 0) pos = (pos + skipped) % mask.length();
+        return skipped;
+    }
+
+    const RhythmMask &getMask() const
+    {
+        return mask;
+    }
+
+    void save(StateWriter &out) const override
+    {
+        out.tag("PRHY");
+        out.write(pos);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PRHY");
+        in.read(pos);
+        if (pos < 0 || pos >= mask.length())
+            throw std::runtime_error("Snapshot position outside rhythm");
+    }
+
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PRHY");
+        out.write(mask.length());
+        out.write(mask.getWords());
+        return true;
+    }
+
+private:
+    RhythmMask mask;
+    int pos;
+};
+
+#endif // RHYTHM_H
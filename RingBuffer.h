@@ -0,0 +1,89 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+// Lock-free single-producer/single-consumer ring buffer. Capacity is rounded up
+// to a power of two. push() may only be called from one thread and pop()/front()
+// from one other thread; size() is safe from either.
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(size_t capacity)
+        : slots(roundUp(capacity)), mask(slots.size() - 1), head(0), tail(0), cachedHead(0), cachedTail(0)
+    {
+    }
+
+    bool push(const T& value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == slots.size())
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == slots.size()) return false;
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value)
+    {
+        const T* next = front();
+        if (!next) return false;
+        value = *next;
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Oldest element, or nullptr when empty. Stays valid until the next pop().
+    const T* front()
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return nullptr;
+        }
+        return &slots[h & mask];
+    }
+
+    void discard()
+    {
+        if (front()) head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t size() const
+    {
+        size_t h = head.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_acquire);
+        return t - h;
+    }
+
+    size_t capacity() const
+    {
+        return slots.size();
+    }
+
+private:
+    static size_t roundUp(size_t n)
+    {
+        if (n == 0) throw std::invalid_argument("RingBuffer capacity must not be zero");
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) size_t cachedHead; // producer's view of head
+    alignas(64) size_t cachedTail; // consumer's view of tail
+};
+
+#endif // RINGBUFFER_H
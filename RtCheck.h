@@ -0,0 +1,296 @@
+#ifndef RTCHECK_H
+#define RTCHECK_H
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#include <execinfo.h>
+#include <unistd.h>
+
+// Real-time safety checking, a debug mode enabled with ISOBAR_RT_CHECK=1.
+// Threads that must not block (the clock thread, scheduler workers) open an
+// RtScope; while it is open, heap allocation and RtMutex::lock() on that
+// thread are reported as violations with a backtrace. Allocations are only
+// seen if one translation unit defines ISOBAR_RT_CHECK_IMPLEMENT before
+// including this header, which replaces the global operator new/delete.
+#ifndef ISOBAR_RT_CHECK
+#define ISOBAR_RT_CHECK 0
+#endif
+
+enum class RtViolationKind
+{
+    Allocation,
+    Lock
+};
+
+struct RtViolation
+{
+    static constexpr int MaxFrames = 32;
+
+    RtViolationKind kind;
+    const char *what;
+    void *frames[MaxFrames];
+    int depth;
+};
+
+class RtCheck
+{
+public:
+    using Reporter = void (*)(const RtViolation &);
+
+    // Called for each violation on the violating thread. Checking is suspended
+    // while it runs, so it may allocate. The default prints to stderr.
+    static void setReporter(Reporter reporter)
+    {
+        reporterSlot().store(reporter ? reporter : &printViolation, std::memory_order_release);
+    }
+
+    static unsigned long getViolations(RtViolationKind kind)
+    {
+        return counter(kind).load(std::memory_order_relaxed);
+    }
+
+    static void resetViolations()
+    {
+        counter(RtViolationKind::Allocation).store(0, std::memory_order_relaxed);
+        counter(RtViolationKind::Lock).store(0, std::memory_order_relaxed);
+    }
+
+    static bool isRealtime()
+    {
+        return state().realtime && !state().reporting;
+    }
+
+    static void violation(RtViolationKind kind, const char *what)
+    {
+        if (!isRealtime()) return;
+
+        state().reporting = true;
+        counter(kind).fetch_add(1, std::memory_order_relaxed);
+        RtViolation report;
+        report.kind = kind;
+        report.what = what;
+        report.depth = ::backtrace(report.frames, RtViolation::MaxFrames);
+        reporterSlot().load(std::memory_order_acquire)(report);
+        state().reporting = false;
+    }
+
+    static void printViolation(const RtViolation &report)
+    {
+        std::fprintf(stderr, "real-time violation: %s\n", report.what);
+        ::backtrace_symbols_fd(report.frames, report.depth, STDERR_FILENO);
+    }
+
+private:
+    friend class RtScope;
+    friend class RtExempt;
+
+    struct ThreadState
+    {
+        bool realtime;
+        bool reporting;
+    };
+
+    static ThreadState &state()
+    {
+        thread_local ThreadState threadState{false, false};
+        return threadState;
+    }
+
+    static std::atomic<unsigned long> &counter(RtViolationKind kind)
+    {
+        static std::atomic<unsigned long> counts[2];
+        return counts[static_cast<int>(kind)];
+    }
+
+    static std::atomic<Reporter> &reporterSlot()
+    {
+        static std::atomic<Reporter> reporter(&printViolation);
+        return reporter;
+    }
+};
+
+// Marks the current thread as real-time for the lifetime of the scope. Does
+// nothing unless ISOBAR_RT_CHECK is enabled.
+class RtScope
+{
+public:
+    RtScope()
+    {
+#if ISOBAR_RT_CHECK
+        // The first backtrace() loads the unwinder, which allocates; do it now.
+        void *frame;
+        ::backtrace(&frame, 1);
+        previous = RtCheck::state().realtime;
+        RtCheck::state().realtime = true;
+#endif
+    }
+
+    ~RtScope()
+    {
+#if ISOBAR_RT_CHECK
+        RtCheck::state().realtime = previous;
+#endif
+    }
+
+    RtScope(const RtScope &) = delete;
+    RtScope &operator=(const RtScope &) = delete;
+
+private:
+    bool previous = false;
+};
+
+// Suspends checking on the current thread for the lifetime of the scope, for
+// work that is documented as not real-time safe and opted into by the user.
+class RtExempt
+{
+public:
+    RtExempt()
+    {
+#if ISOBAR_RT_CHECK
+        previous = RtCheck::state().realtime;
+        RtCheck::state().realtime = false;
+#endif
+    }
+
+    ~RtExempt()
+    {
+#if ISOBAR_RT_CHECK
+        RtCheck::state().realtime = previous;
+#endif
+    }
+
+    RtExempt(const RtExempt &) = delete;
+    RtExempt &operator=(const RtExempt &) = delete;
+
+private:
+    bool previous = false;
+};
+
+// std::mutex that reports blocking acquisition from a real-time thread.
+// try_lock() never blocks and is not reported.
+class CheckedMutex
+{
+public:
+    void lock()
+    {
+        RtCheck::violation(RtViolationKind::Lock, "mutex lock");
+        mutex.lock();
+    }
+
+    bool try_lock()
+    {
+        return mutex.try_lock();
+    }
+
+    void unlock()
+    {
+        mutex.unlock();
+    }
+
+private:
+    std::mutex mutex;
+};
+
+#if ISOBAR_RT_CHECK
+using RtMutex = CheckedMutex;
+#else
+using RtMutex = std::mutex;
+#endif
+
+#endif // RTCHECK_H
+
+#if defined(ISOBAR_RT_CHECK_IMPLEMENT) && !defined(RTCHECK_IMPLEMENTED)
+#define RTCHECK_IMPLEMENTED
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// The malloc/free pair stays out of line: inlined into the replacement
+// operators, GCC would see free() applied to the result of operator new and
+// warn with -Wmismatched-new-delete.
+[[gnu::noinline]] inline void *rtCheckAllocate(std::size_t size, std::size_t alignment = 0)
+{
+    RtCheck::violation(RtViolationKind::Allocation, "operator new");
+    if (size == 0) size = 1;
+    void *p = nullptr;
+    if (alignment > alignof(std::max_align_t))
+    {
+        if (::posix_memalign(&p, alignment, size) != 0) p = nullptr;
+    }
+    else
+    {
+        p = std::malloc(size);
+    }
+    return p;
+}
+
+[[gnu::noinline]] inline void rtCheckFree(void *p)
+{
+    if (!p) return;
+    RtCheck::violation(RtViolationKind::Allocation, "operator delete");
+    std::free(p);
+}
+
+void *operator new(std::size_t size)
+{
+    if (void *p = rtCheckAllocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    if (void *p = rtCheckAllocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void *p = rtCheckAllocate(size, static_cast<std::size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    if (void *p = rtCheckAllocate(size, static_cast<std::size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return rtCheckAllocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return rtCheckAllocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return rtCheckAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return rtCheckAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+// Each delete forwards to the one matching its new; the sized forms add
+// nothing to the unsized ones.
+void operator delete(void *p) noexcept { rtCheckFree(p); }
+void operator delete[](void *p) noexcept { rtCheckFree(p); }
+void operator delete(void *p, std::align_val_t) noexcept { rtCheckFree(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { rtCheckFree(p); }
+void operator delete(void *p, std::size_t) noexcept { ::operator delete(p); }
+void operator delete[](void *p, std::size_t) noexcept { ::operator delete[](p); }
+void operator delete(void *p, std::size_t, std::align_val_t alignment) noexcept { ::operator delete(p, alignment); }
+void operator delete[](void *p, std::size_t, std::align_val_t alignment) noexcept { ::operator delete[](p, alignment); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { ::operator delete(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { ::operator delete[](p); }
+void operator delete(void *p, std::align_val_t alignment, const std::nothrow_t &) noexcept { ::operator delete(p, alignment); }
+void operator delete[](void *p, std::align_val_t alignment, const std::nothrow_t &) noexcept { ::operator delete[](p, alignment); }
+
+#endif // ISOBAR_RT_CHECK_IMPLEMENT
@@ -0,0 +1,203 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+
+#include "Timeline.h"
+
+// Drives many timelines from one thread (or a small fixed pool) instead of one
+// Clock thread per timeline. Pending ticks sit in a min-heap keyed by deadline;
+// each deadline is computed exactly from the timeline's own TimeBase as
+// origin + t(n), so timing does not drift however late a tick runs. The time
+// base is read again after every tick, so Timeline::setTempo() takes effect
+// from the next deadline, which is then counted from the current one. Each
+// tick runs inside an RtScope.
+class Scheduler
+{
+public:
+    explicit Scheduler(unsigned numThreads = 1)
+        : stopping(false), lateTicks(0), totalTicks(0), nextSequence(0)
+    {
+        for (unsigned i = 0; i < std::max(1u, numThreads); ++i)
+        {
+            workers.emplace_back(&Scheduler::run, this);
+        }
+    }
+
+    ~Scheduler()
+    {
+        stop();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return;
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+        {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    // Starts ticking the timeline now. A timeline must not also be started on
+    // its own Clock while it is scheduled here.
+    void add(const std::shared_ptr<Timeline> &timeline)
+    {
+        auto slot = std::make_shared<Slot>();
+        slot->timeline = timeline;
+        slot->timeBase = timeline->getTimeBase();
+        slot->origin = std::chrono::steady_clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots[timeline.get()] = slot;
+            heap.push(Entry{slot->origin, nextSequence++, 0, slot});
+        }
+        wake.notify_one();
+    }
+
+    // Stops ticking the timeline. Once this returns no tick of it is in
+    // progress, so it must not be called from that timeline's own output.
+    void remove(const std::shared_ptr<Timeline> &timeline)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = slots.find(timeline.get());
+        if (it == slots.end()) return;
+        auto slot = it->second;
+        slot->removed = true;
+        slots.erase(it);
+        idle.wait(lock, [&slot]() { return !slot->ticking; });
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return slots.size();
+    }
+
+    // Ticks that started after their deadline, and all ticks run so far.
+    unsigned long getLateTicks() const
+    {
+        return lateTicks.load(std::memory_order_relaxed);
+    }
+
+    unsigned long getTotalTicks() const
+    {
+        return totalTicks.load(std::memory_order_relaxed);
+    }
+
+private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    struct Slot
+    {
+        std::shared_ptr<Timeline> timeline;
+        TimeBase timeBase;
+        TimePoint origin;
+        bool removed = false;
+        bool ticking = false;
+    };
+
+    struct Entry
+    {
+        TimePoint deadline;
+        unsigned long sequence; // FIFO among equal deadlines
+        Tick tick;              // ticks since the slot's origin
+        std::shared_ptr<Slot> slot;
+
+        bool operator>(const Entry &other) const
+        {
+            if (deadline != other.deadline) return deadline > other.deadline;
+            return sequence > other.sequence;
+        }
+    };
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping)
+        {
+            if (heap.empty())
+            {
+                wake.wait(lock);
+                continue;
+            }
+
+            TimePoint deadline = heap.top().deadline;
+            if (std::chrono::steady_clock::now() < deadline)
+            {
+                wake.wait_until(lock, deadline);
+                continue;
+            }
+
+            Entry entry = heap.top();
+            heap.pop();
+            if (entry.slot->removed) continue;
+
+            // A timeline is in the heap at most once, so no two workers ever
+            // tick the same timeline concurrently.
+            entry.slot->ticking = true;
+            lock.unlock();
+            auto period = std::chrono::nanoseconds(entry.slot->timeBase.ticksToNanos(entry.tick + 1) -
+                                                   entry.slot->timeBase.ticksToNanos(entry.tick));
+            if (std::chrono::steady_clock::now() - entry.deadline > period)
+            {
+                lateTicks.fetch_add(1, std::memory_order_relaxed);
+            }
+            {
+                // Only the tick itself is real-time work; the heap and its
+                // lock are the scheduler's own bookkeeping.
+                RtScope realtime;
+                entry.slot->timeline->tick();
+            }
+            totalTicks.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+            entry.slot->ticking = false;
+
+            if (entry.slot->removed)
+            {
+                idle.notify_all();
+                continue;
+            }
+            TimeBase current = entry.slot->timeline->getTimeBase();
+            if (current != entry.slot->timeBase)
+            {
+                // Tempo change: count from this tick's deadline at the new rate.
+                entry.slot->origin += std::chrono::nanoseconds(entry.slot->timeBase.ticksToNanos(entry.tick));
+                entry.slot->timeBase = current;
+                entry.tick = 0;
+            }
+            entry.tick++;
+            entry.deadline = entry.slot->origin + std::chrono::nanoseconds(entry.slot->timeBase.ticksToNanos(entry.tick));
+            entry.sequence = nextSequence++;
+            bool earliest = heap.empty() || entry.deadline < heap.top().deadline;
+            heap.push(entry);
+            if (earliest && workers.size() > 1) wake.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    bool stopping;
+    std::atomic<unsigned long> lateTicks;
+    std::atomic<unsigned long> totalTicks;
+    unsigned long nextSequence;
+    std::unordered_map<const Timeline *, std::shared_ptr<Slot>> slots;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+};
+
+#endif // SCHEDULER_H
@@ -8,13 +8,37 @@
 #include <stdexcept>
 #include <iostream>
 #include <memory>
+#include <span>
+#include <algorithm>
+#include <cstdint>
 
 // PSequence
+// The values live in immutable storage that is either shared (refcounted) or
+// owned by the caller, so copies of a PSequence, and every sequence built from
+// the same table, read one copy of the data.
 class PSequence : public Pattern
 {
 public:
     PSequence(const std::vector<double>& sequence, int repeats = std::numeric_limits<int>::max())
-        : sequence(sequence), repeats(repeats), pos(0), rcount(0)
+        : PSequence(std::make_shared<const std::vector<double>>(sequence), repeats)
+    {
+    }
+
+    // Shares a refcounted table; nothing is copied.
+    PSequence(std::shared_ptr<const std::vector<double>> sequence, int repeats = std::numeric_limits<int>::max())
+        : PSequence(sequence, sequence ? std::span<const double>(*sequence) : std::span<const double>(), repeats)
+    {
+    }
+
+    // References caller-owned storage, which must outlive the pattern.
+    PSequence(std::span<const double> sequence, int repeats = std::numeric_limits<int>::max())
+        : PSequence(nullptr, sequence, repeats)
+    {
+    }
+
+    // References storage kept alive by owner, e.g. a slice of a mapped file.
+    PSequence(std::shared_ptr<const void> owner, std::span<const double> sequence, int repeats = std::numeric_limits<int>::max())
+        : owner(std::move(owner)), sequence(sequence), repeats(repeats), pos(0), rcount(0)
     {
         if (sequence.empty())
             throw std::invalid_argument("Sequence must not be empty");
@@ -41,10 +65,66 @@ public:
         return value;
     }
 
+    // Copies the first period from the table, then doubles the output onto
+    // itself, so a long block is a handful of memcpys whatever the period.
+    size_t nextBlock(double *out, size_t count) override
+    {
+        const size_t size = sequence.size();
+        if (rcount >= repeats) return 0;
+        std::uint64_t available = static_cast<std::uint64_t>(repeats - rcount) * size - pos;
+        size_t n = static_cast<size_t>(std::min<std::uint64_t>(count, available));
+
+        size_t first = std::min(n, size);
+        size_t head = std::min(first, size - pos);
+        std::copy_n(sequence.data() + pos, head, out);
+        std::copy_n(sequence.data(), first - head, out + head);
+        for (size_t done = first; done < n;)
+        {
+            size_t chunk = std::min(done, n - done);
+            std::copy_n(out, chunk, out + done);
+            done += chunk;
+        }
+
+        pos += n;
+        rcount += static_cast<int>(pos / size);
+        pos %= size;
+        return n;
+    }
+
+    void save(StateWriter &out) const override
+    {
+        out.tag("PSEQ");
+        out.write(pos);
+        out.write(rcount);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PSEQ");
+        in.read(pos);
+        in.read(rcount);
+        if (pos >= sequence.size())
+            throw std::runtime_error("Snapshot position outside sequence");
+    }
+
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PSEQ");
+        out.write(repeats);
+        out.write(sequence);
+        return true;
+    }
+
+    std::span<const double> values() const
+    {
+        return sequence;
+    }
+
 private:
-    std::vector<double> sequence;
+    std::shared_ptr<const void> owner;
+    std::span<const double> sequence;
     int repeats;
-    int pos;
+    size_t pos;
     int rcount;
 };
 
@@ -72,6 +152,41 @@ public:
         return current;
     }
 
+    size_t nextBlock(double *out, size_t blockSize) override
+    {
+        size_t n = std::min(blockSize, static_cast<size_t>(std::max(0, length - count)));
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = value;
+            value += step;
+        }
+        count += static_cast<int>(n);
+        return n;
+    }
+
+    void save(StateWriter &out) const override
+    {
+        out.tag("PSER");
+        out.write(value);
+        out.write(count);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PSER");
+        in.read(value);
+        in.read(count);
+    }
+
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PSER");
+        out.write(start);
+        out.write(step);
+        out.write(length);
+        return true;
+    }
+
 private:
     double start;
     double step;
@@ -102,6 +217,27 @@ public:
         return current;
     }
 
+    void save(StateWriter &out) const override
+    {
+        out.tag("PRNG");
+        out.write(value);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PRNG");
+        in.read(value);
+    }
+
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PRNG");
+        out.write(start);
+        out.write(end);
+        out.write(step);
+        return true;
+    }
+
 private:
     double start;
     double end;
@@ -133,6 +269,29 @@ public:
         return current;
     }
 
+    void save(StateWriter &out) const override
+    {
+        out.tag("PGEO");
+        out.write(value);
+        out.write(count);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PGEO");
+        in.read(value);
+        in.read(count);
+    }
+
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PGEO");
+        out.write(start);
+        out.write(multiply);
+        out.write(length);
+        return true;
+    }
+
 private:
     double start;
     double multiply;
@@ -155,10 +314,29 @@ public:
     double next() override
     {
         int current = (pos == 0) ? 1 : 0;
-        pos = (pos + 1) % period;
+        if (++pos >= period) pos = 0;
         return current;
     }
 
+    void save(StateWriter &out) const override
+    {
+        out.tag("PIMP");
+        out.write(pos);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PIMP");
+        in.read(pos);
+    }
+
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PIMP");
+        out.write(period);
+        return true;
+    }
+
 private:
     int period;
     int pos;
@@ -205,6 +383,42 @@ public:
         return values[pos++];
     }
 
+    size_t bufferBytes() const override
+    {
+        return values.capacity() * sizeof(double);
+    }
+
+    // The recording is part of the state: once readAll is set the source is
+    // never read again, so it has to come back byte for byte.
+    void save(StateWriter &out) const override
+    {
+        out.tag("PLOP");
+        out.write(loopIndex);
+        out.write(pos);
+        out.write(readAll);
+        out.write(values);
+        pattern->save(out);
+    }
+
+    void load(StateReader &in) override
+    {
+        in.tag("PLOP");
+        in.read(loopIndex);
+        in.read(pos);
+        in.read(readAll);
+        in.read(values);
+        if (pos > values.size())
+            throw std::runtime_error("Snapshot position outside loop recording");
+        pattern->load(in);
+    }
+
+    bool signature(StateWriter &out) const override
+    {
+        out.tag("PLOP");
+        out.write(count);
+        return pattern->signature(out);
+    }
+
 private:
     std::shared_ptr<Pattern> pattern;
     int count;
@@ -0,0 +1,127 @@
+#ifndef STATE_H
+#define STATE_H
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Runtime state of a pattern graph or timeline as raw bytes. Only positions,
+// counters, recorded values and RNG state are stored, never the structure:
+// a snapshot is restored into a graph built the same way, so failing over or
+// forking a variation is one pass of memcpys with no allocation beyond
+// PLoop's recordings. Values are stored in native byte order.
+using Snapshot = std::vector<std::uint8_t>;
+
+class StateWriter
+{
+public:
+    // Four-character marker checked on restore, so that loading into a graph
+    // of a different shape fails instead of scrambling it.
+    void tag(const char (&name)[5])
+    {
+        append(name, 4);
+    }
+
+    template <typename T>
+    void write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        append(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void write(std::span<const T> values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write<std::uint64_t>(values.size());
+        append(values.data(), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    void write(const std::vector<T> &values)
+    {
+        write(std::span<const T>(values));
+    }
+
+    const Snapshot &data() const
+    {
+        return bytes;
+    }
+
+    Snapshot take()
+    {
+        return std::move(bytes);
+    }
+
+private:
+    void append(const void *data, size_t size)
+    {
+        const auto *begin = static_cast<const std::uint8_t *>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+
+    Snapshot bytes;
+};
+
+class StateReader
+{
+public:
+    explicit StateReader(std::span<const std::uint8_t> bytes) : bytes(bytes), pos(0) {}
+
+    void tag(const char (&name)[5])
+    {
+        if (remaining() < 4 || std::memcmp(bytes.data() + pos, name, 4) != 0)
+            throw std::runtime_error(std::string("Snapshot does not match graph: expected ") + name);
+        pos += 4;
+    }
+
+    template <typename T>
+    T read()
+    {
+        T value;
+        read(value);
+        return value;
+    }
+
+    template <typename T>
+    void read(T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        extract(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void read(std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        std::uint64_t size = read<std::uint64_t>();
+        if (size > remaining() / sizeof(T))
+            throw std::runtime_error("Snapshot truncated");
+        values.resize(size);
+        extract(values.data(), size * sizeof(T));
+    }
+
+    size_t remaining() const
+    {
+        return bytes.size() - pos;
+    }
+
+private:
+    void extract(void *data, size_t size)
+    {
+        if (size > remaining())
+            throw std::runtime_error("Snapshot truncated");
+        std::memcpy(data, bytes.data() + pos, size);
+        pos += size;
+    }
+
+    std::span<const std::uint8_t> bytes;
+    size_t pos;
+};
+
+#endif // STATE_H
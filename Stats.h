@@ -0,0 +1,211 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <functional>
+#include <algorithm>
+
+// Read-only copy of a Histogram taken at one moment.
+struct HistogramSnapshot
+{
+    std::vector<std::uint64_t> counts;
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t max = 0;
+
+    double mean() const
+    {
+        return count ? static_cast<double>(sum) / count : 0.0;
+    }
+
+    // Upper bound of the bucket holding the p-th quantile (0 <= p <= 1).
+    std::uint64_t percentile(double p) const;
+};
+
+// HDR-style histogram of non-negative integer values (nanoseconds, usually).
+// Buckets are log-linear: each power of two is split into 2^SubBits equal
+// sub-buckets, so the relative error is bounded (about 6% with SubBits = 4)
+// from 1 ns up to 2^63. record() is wait-free: an index computation and three
+// relaxed atomic updates, safe from any number of threads.
+class Histogram
+{
+public:
+    static constexpr int SubBits = 4;
+    static constexpr int SubCount = 1 << SubBits;
+    static constexpr int NumBuckets = (64 - SubBits + 1) * SubCount;
+
+    Histogram()
+    {
+        reset();
+    }
+
+    void record(std::uint64_t value)
+    {
+        counts[indexOf(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        std::uint64_t seen = max.load(std::memory_order_relaxed);
+        while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void reset()
+    {
+        for (auto &count : counts) count.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot snapshot() const
+    {
+        HistogramSnapshot s;
+        s.counts.resize(NumBuckets);
+        for (int i = 0; i < NumBuckets; ++i) s.counts[i] = counts[i].load(std::memory_order_relaxed);
+        s.count = total.load(std::memory_order_relaxed);
+        s.sum = sum.load(std::memory_order_relaxed);
+        s.max = max.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    static int indexOf(std::uint64_t value)
+    {
+        if (value < SubCount) return static_cast<int>(value);
+        int exponent = 63 - __builtin_clzll(value); // >= SubBits
+        int shift = exponent - SubBits;
+        return (shift + 1) * SubCount + static_cast<int>((value >> shift) & (SubCount - 1));
+    }
+
+    // Largest value that maps to the bucket.
+    static std::uint64_t upperBound(int index)
+    {
+        if (index < SubCount) return static_cast<std::uint64_t>(index);
+        int shift = index / SubCount - 1;
+        std::uint64_t base = (static_cast<std::uint64_t>(SubCount) | (index % SubCount)) << shift;
+        return base + ((std::uint64_t(1) << shift) - 1);
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, NumBuckets> counts;
+    std::atomic<std::uint64_t> total;
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> max;
+};
+
+inline std::uint64_t HistogramSnapshot::percentile(double p) const
+{
+    if (count == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(p * (count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank) return std::min(Histogram::upperBound(static_cast<int>(i)), max);
+    }
+    return max;
+}
+
+inline std::ostream &operator<<(std::ostream &out, const HistogramSnapshot &h)
+{
+    out << "count=" << h.count << " mean=" << h.mean() << " p50=" << h.percentile(0.5)
+        << " p99=" << h.percentile(0.99) << " p999=" << h.percentile(0.999) << " max=" << h.max;
+    return out;
+}
+
+struct ClockStats
+{
+    HistogramSnapshot lateness; // ns between a tick's deadline and the wake-up
+    HistogramSnapshot callback; // ns spent in the tick callback
+    std::uint64_t overruns;     // ticks whose callback ran past the next deadline
+    std::uint64_t ticks;
+};
+
+inline std::ostream &operator<<(std::ostream &out, const ClockStats &s)
+{
+    out << "clock ticks=" << s.ticks << " overruns=" << s.overruns << "\n"
+        << "  lateness_ns " << s.lateness << "\n"
+        << "  callback_ns " << s.callback << "\n";
+    return out;
+}
+
+struct TrackStats
+{
+    int track;
+    std::string name;
+    std::uint64_t evaluations;
+    std::uint64_t totalNanos;
+    std::uint64_t maxNanos;
+};
+
+struct TimelineStats
+{
+    HistogramSnapshot tick; // ns to evaluate and dispatch one tick
+    std::vector<TrackStats> tracks; // filled when track timing is enabled
+};
+
+inline std::ostream &operator<<(std::ostream &out, const TimelineStats &s)
+{
+    out << "timeline tick_ns " << s.tick << "\n";
+    for (const auto &t : s.tracks)
+    {
+        out << "  track " << t.track << " [" << t.name << "] evaluations=" << t.evaluations
+            << " mean_ns=" << (t.evaluations ? t.totalNanos / t.evaluations : 0) << " max_ns=" << t.maxNanos << "\n";
+    }
+    return out;
+}
+
+// Calls dump every interval on a background thread until destroyed, e.g. to
+// write Clock/Timeline snapshots to a log that alerting can watch.
+class PeriodicDump
+{
+public:
+    PeriodicDump(std::chrono::milliseconds interval, std::function<void()> dump)
+        : interval(interval), dump(std::move(dump)), stopping(false)
+    {
+        worker = std::thread(&PeriodicDump::run, this);
+    }
+
+    ~PeriodicDump()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    PeriodicDump(const PeriodicDump &) = delete;
+    PeriodicDump &operator=(const PeriodicDump &) = delete;
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!wake.wait_for(lock, interval, [this]() { return stopping; }))
+        {
+            lock.unlock();
+            dump();
+            lock.lock();
+        }
+    }
+
+    std::chrono::milliseconds interval;
+    std::function<void()> dump;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+};
+
+#endif // STATS_H
@@ -0,0 +1,206 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <algorithm>
+
+// Work-stealing thread pool. Each worker owns a deque of index ranges; it splits
+// the range it is working on and pushes the upper half back onto its own deque,
+// where idle workers can steal it. The calling thread of parallelFor() takes part
+// in the work, so a pool of N workers runs on N + 1 threads.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned numThreads = std::max(1u, std::thread::hardware_concurrency()) - 1)
+        : queues(numThreads + 1), stopping(false), pending(0)
+    {
+        for (unsigned i = 0; i < numThreads; ++i)
+        {
+            workers.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that execute work, including the caller of parallelFor().
+    unsigned concurrency() const
+    {
+        return static_cast<unsigned>(workers.size()) + 1;
+    }
+
+    // Calls body(i) for every i in [0, count) and returns when all calls have
+    // completed. The first exception thrown by body is rethrown here. Not
+    // real-time safe: it queues tasks under the pool's locks.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body, size_t grain = 1)
+    {
+        if (count == 0) return;
+        if (workers.empty() || count <= grain)
+        {
+            for (size_t i = 0; i < count; ++i) body(i);
+            return;
+        }
+
+        Job job(body, count, std::max<size_t>(1, grain));
+        push(0, Task{&job, 0, count});
+
+        // The caller services the pool until its own job has drained.
+        while (job.remaining.load(std::memory_order_acquire) > 0)
+        {
+            Task task;
+            if (pop(0, task) || steal(0, task))
+            {
+                execute(0, task);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        if (job.error)
+        {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+private:
+    struct Job
+    {
+        Job(const std::function<void(size_t)>& body, size_t count, size_t grain)
+            : body(body), remaining(count), grain(grain) {}
+
+        const std::function<void(size_t)>& body;
+        std::atomic<size_t> remaining;
+        size_t grain;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    struct Task
+    {
+        Job* job = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void push(unsigned self, const Task& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues[self].mutex);
+            queues[self].tasks.push_back(task);
+        }
+        pending.fetch_add(1, std::memory_order_release);
+        // Touch the sleep mutex so a worker between its predicate check and wait() can't miss this.
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wake.notify_one();
+    }
+
+    // Owners take from the back of their deque (most recently split, cache-warm)...
+    bool pop(unsigned self, Task& task)
+    {
+        std::lock_guard<std::mutex> lock(queues[self].mutex);
+        if (queues[self].tasks.empty()) return false;
+        task = queues[self].tasks.back();
+        queues[self].tasks.pop_back();
+        pending.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // ...thieves take from the front, where the largest ranges sit.
+    bool steal(unsigned self, Task& task)
+    {
+        for (size_t n = 1; n < queues.size(); ++n)
+        {
+            Queue& victim = queues[(self + n) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                pending.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void execute(unsigned self, Task task)
+    {
+        Job& job = *task.job;
+        while (task.end - task.begin > job.grain)
+        {
+            size_t mid = task.begin + (task.end - task.begin) / 2;
+            push(self, Task{&job, mid, task.end});
+            task.end = mid;
+        }
+
+        for (size_t i = task.begin; i < task.end; ++i)
+        {
+            try
+            {
+                job.body(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(job.errorMutex);
+                if (!job.error) job.error = std::current_exception();
+            }
+        }
+
+        job.remaining.fetch_sub(task.end - task.begin, std::memory_order_acq_rel);
+    }
+
+    void workerLoop(unsigned self)
+    {
+        while (true)
+        {
+            Task task;
+            if (pop(self, task) || steal(self, task))
+            {
+                execute(self, task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this]() { return stopping || pending.load(std::memory_order_acquire) > 0; });
+            if (stopping) return;
+        }
+    }
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::atomic<size_t> pending;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,175 @@
+#ifndef TIME_H
+#define TIME_H
+
+#include <bit>
+#include <cstdint>
+#include <cmath>
+#include <stdexcept>
+
+// Timeline positions are whole ticks, so scheduling comparisons and sorts are
+// exact integer operations that never drift over a long session.
+using Tick = std::int64_t;
+
+// a * b / c rounded down (or up), for b, c > 0, through a 128-bit intermediate
+// built from 64-bit halves, so it needs no compiler extension. The quotient
+// must fit in 64 bits.
+inline std::int64_t mulDiv(std::int64_t a, std::int64_t b, std::int64_t c, bool roundUp = false)
+{
+    const std::uint64_t mask = 0xffffffffull;
+    const bool negative = a < 0;
+    const std::uint64_t ua = negative ? 0 - static_cast<std::uint64_t>(a) : static_cast<std::uint64_t>(a);
+    const std::uint64_t ub = static_cast<std::uint64_t>(b);
+    std::uint64_t v = static_cast<std::uint64_t>(c);
+
+    // 64 x 64 -> 128 from four 32 x 32 products.
+    std::uint64_t ll = (ua & mask) * (ub & mask), lh = (ua & mask) * (ub >> 32);
+    std::uint64_t hl = (ua >> 32) * (ub & mask), hh = (ua >> 32) * (ub >> 32);
+    std::uint64_t mid = (ll >> 32) + (lh & mask) + (hl & mask);
+    std::uint64_t lo = (mid << 32) | (ll & mask);
+    std::uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    if (hi >= v)
+        throw std::overflow_error("Time conversion overflows 64 bits");
+
+    // 128 / 64 long division in 32-bit digits (Knuth's algorithm D, as in
+    // Hacker's Delight divlu), normalised so the divisor's top bit is set.
+    const std::uint64_t base = 1ull << 32;
+    int shift = std::countl_zero(v);
+    v <<= shift;
+    std::uint64_t vn1 = v >> 32, vn0 = v & mask;
+    std::uint64_t un32 = shift ? (hi << shift) | (lo >> (64 - shift)) : hi;
+    std::uint64_t un10 = lo << shift;
+    std::uint64_t un1 = un10 >> 32, un0 = un10 & mask;
+
+    std::uint64_t q1 = un32 / vn1, rhat = un32 - q1 * vn1;
+    while (q1 >= base || q1 * vn0 > base * rhat + un1)
+    {
+        q1--;
+        rhat += vn1;
+        if (rhat >= base) break;
+    }
+    std::uint64_t un21 = un32 * base + un1 - q1 * v;
+    std::uint64_t q0 = un21 / vn1;
+    rhat = un21 - q0 * vn1;
+    while (q0 >= base || q0 * vn0 > base * rhat + un0)
+    {
+        q0--;
+        rhat += vn1;
+        if (rhat >= base) break;
+    }
+    std::uint64_t quotient = q1 * base + q0;
+    bool remainder = (un21 * base + un0 - q0 * v) != 0;
+
+    quotient += negative ? !roundUp && remainder : roundUp && remainder;
+    if (quotient > static_cast<std::uint64_t>(INT64_MAX) + negative)
+        throw std::overflow_error("Time conversion overflows 64 bits");
+    return negative ? static_cast<std::int64_t>(0 - quotient) : static_cast<std::int64_t>(quotient);
+}
+
+// Tempo and resolution of a timeline. Tempo is held as integer microseconds per
+// beat (the Standard MIDI File representation), which makes every conversion
+// between ticks and wall-clock time an exact rational computation; doubles only
+// appear at the edges, in the beat/second converters.
+class TimeBase
+{
+public:
+    TimeBase(double tempo = 120.0, int ticksPerBeat = 480)
+        : microsPerBeat(microsFor(tempo)), ticksPerBeat(ticksPerBeat)
+    {
+        if (ticksPerBeat <= 0)
+            throw std::invalid_argument("Tempo and ticks per beat must be positive");
+    }
+
+    static TimeBase fromMicrosPerBeat(std::int64_t microsPerBeat, int ticksPerBeat)
+    {
+        TimeBase base(120.0, ticksPerBeat);
+        if (microsPerBeat <= 0)
+            throw std::invalid_argument("Microseconds per beat must be positive");
+        base.microsPerBeat = microsPerBeat;
+        return base;
+    }
+
+    double getTempo() const
+    {
+        return 60e6 / static_cast<double>(microsPerBeat);
+    }
+
+    std::int64_t getMicrosPerBeat() const
+    {
+        return microsPerBeat;
+    }
+
+    int getTicksPerBeat() const
+    {
+        return ticksPerBeat;
+    }
+
+    Tick beatsToTicks(double beats) const
+    {
+        return static_cast<Tick>(std::llround(beats * ticksPerBeat));
+    }
+
+    double ticksToBeats(Tick ticks) const
+    {
+        return static_cast<double>(ticks) / ticksPerBeat;
+    }
+
+    double ticksToSeconds(Tick ticks) const
+    {
+        return static_cast<double>(ticksToNanos(ticks)) * 1e-9;
+    }
+
+    Tick secondsToTicks(double seconds) const
+    {
+        return nanosToTicks(static_cast<std::int64_t>(std::llround(seconds * 1e9)));
+    }
+
+    // First whole nanosecond at or after the start of the tick.
+    std::int64_t ticksToNanos(Tick ticks) const
+    {
+        return mulDiv(ticks, microsPerBeat * 1000, ticksPerBeat, true);
+    }
+
+    // Tick containing the given instant.
+    Tick nanosToTicks(std::int64_t nanos) const
+    {
+        return mulDiv(nanos, ticksPerBeat, microsPerBeat * 1000);
+    }
+
+    // First audio frame at or after the start of the tick.
+    std::int64_t ticksToFrames(Tick ticks, std::int64_t sampleRate) const
+    {
+        return mulDiv(ticks, microsPerBeat * sampleRate, std::int64_t(ticksPerBeat) * 1000000, true);
+    }
+
+    // Number of ticks whose first frame (as ticksToFrames) lies before the given frame.
+    Tick framesToTicks(std::int64_t frames, std::int64_t sampleRate) const
+    {
+        if (frames <= 0) return 0;
+        return mulDiv(frames - 1, std::int64_t(ticksPerBeat) * 1000000, microsPerBeat * sampleRate) + 1;
+    }
+
+    bool operator==(const TimeBase &other) const
+    {
+        return microsPerBeat == other.microsPerBeat && ticksPerBeat == other.ticksPerBeat;
+    }
+
+    bool operator!=(const TimeBase &other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    static std::int64_t microsFor(double tempo)
+    {
+        // Checked before dividing: 60e6 / 0 is infinite and llround of that
+        // is undefined.
+        if (!(tempo > 0.0) || !(60e6 / tempo < 9.2e18))
+            throw std::invalid_argument("Tempo and ticks per beat must be positive");
+        return std::llround(60e6 / tempo);
+    }
+
+    std::int64_t microsPerBeat;
+    int ticksPerBeat;
+};
+
+#endif // TIME_H
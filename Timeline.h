@@ -7,20 +7,55 @@
 #include <chrono>
 #include <vector>
 #include <memory>
-#include <iostream>
 #include <functional>
 #include <algorithm>
+#include <string>
+
+#include "Pattern.h"
+#include "ThreadPool.h"
+#include "Time.h"
+#include "Trace.h"
+#include "Stats.h"
+#include "RtCheck.h"
+#include "Voice.h"
+
+struct Event
+{
+    Tick tick;
+    int track;
+    int channel;
+    int note;
+    int velocity;
+    Tick duration;
+};
+
+// An event produced by Timeline::process, positioned inside the host's block.
+struct BlockEvent
+{
+    Event event;
+    int offset; // frames from the start of the block
+};
 
 class Clock
 {
 public:
     Clock(double tempo = 120.0, int ticksPerBeat = 480)
-        : tempo(tempo), ticksPerBeat(ticksPerBeat), running(false) {}
+        : Clock(TimeBase(tempo, ticksPerBeat)) {}
 
+    explicit Clock(const TimeBase &timeBase)
+        : microsPerBeat(timeBase.getMicrosPerBeat()), ticksPerBeat(timeBase.getTicksPerBeat()),
+          running(false), overruns(0), completedTicks(0) {}
+
+    // The tempo is a single atomic word, so the clock thread reads it without
+    // taking a lock.
     void setTempo(double newTempo)
     {
-        std::lock_guard<std::mutex> lock(clockMutex);
-        tempo = newTempo;
+        microsPerBeat.store(TimeBase(newTempo, ticksPerBeat).getMicrosPerBeat(), std::memory_order_relaxed);
+    }
+
+    TimeBase getTimeBase() const
+    {
+        return TimeBase::fromMicrosPerBeat(microsPerBeat.load(std::memory_order_relaxed), ticksPerBeat);
     }
 
     void start()
@@ -44,41 +79,140 @@ public:
         targetCallback = callback;
     }
 
+    // Lateness of each wake-up against its deadline, time spent in the
+    // callback, and how many callbacks ran past the following deadline.
+    ClockStats stats() const
+    {
+        return ClockStats{lateness.snapshot(), callbackTime.snapshot(),
+                          overruns.load(std::memory_order_relaxed), completedTicks.load(std::memory_order_relaxed)};
+    }
+
+    void resetStats()
+    {
+        lateness.reset();
+        callbackTime.reset();
+        overruns.store(0, std::memory_order_relaxed);
+        completedTicks.store(0, std::memory_order_relaxed);
+    }
+
 private:
+    // Sleeps until absolute deadlines origin + t(n) computed exactly from the
+    // time base, so a late wake-up does not push back later ticks.
     void run()
     {
-        auto tickDuration = std::chrono::milliseconds(static_cast<int>(60000.0 / (tempo * ticksPerBeat)));
+        RtScope realtime;
+        auto origin = std::chrono::steady_clock::now();
+        TimeBase base = getTimeBase();
+        Tick ticks = 0;
         while (running)
         {
-            std::this_thread::sleep_for(tickDuration);
+            TimeBase current = getTimeBase();
+            if (current != base)
+            {
+                // Tempo change: restart counting from the current tick's deadline.
+                origin += std::chrono::nanoseconds(base.ticksToNanos(ticks));
+                base = current;
+                ticks = 0;
+            }
+
+            ticks++;
+            auto deadline = origin + std::chrono::nanoseconds(base.ticksToNanos(ticks));
+            std::this_thread::sleep_until(deadline);
+            auto woke = std::chrono::steady_clock::now();
             if (targetCallback)
             {
                 targetCallback();
             }
+            auto done = std::chrono::steady_clock::now();
+
+            lateness.record(nanosBetween(deadline, woke));
+            callbackTime.record(nanosBetween(woke, done));
+            if (done > origin + std::chrono::nanoseconds(base.ticksToNanos(ticks + 1)))
+            {
+                overruns.fetch_add(1, std::memory_order_relaxed);
+            }
+            completedTicks.fetch_add(1, std::memory_order_relaxed);
         }
     }
 
-    double tempo;
-    int ticksPerBeat;
+    static std::uint64_t nanosBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+        return nanos > 0 ? static_cast<std::uint64_t>(nanos) : 0;
+    }
+
+    std::atomic<std::int64_t> microsPerBeat;
+    const int ticksPerBeat;
     std::atomic<bool> running;
     std::thread clockThread;
     std::function<void()> targetCallback;
-    mutable std::mutex clockMutex;
+    Histogram lateness;
+    Histogram callbackTime;
+    std::atomic<std::uint64_t> overruns;
+    std::atomic<std::uint64_t> completedTicks;
 };
 
 class Track
 {
 public:
-    explicit Track(const std::string &name) : name(name), isFinished(false) {}
+    explicit Track(const std::string &name)
+        : name(name), id(0), channel(0), nextEventTick(0), isFinished(false),
+          evaluations(0), evaluationNanos(0), maxEvaluationNanos(0) {}
 
-    void tick()
+    Track(const std::string &name,
+          std::shared_ptr<Pattern> notes,
+          std::shared_ptr<Pattern> velocities = nullptr,
+          std::shared_ptr<Pattern> durations = nullptr)
+        : name(name), notes(notes), velocities(velocities), durations(durations),
+          id(0), channel(0), nextEventTick(0), isFinished(false),
+          evaluations(0), evaluationNanos(0), maxEvaluationNanos(0) {}
+
+    void tick(Tick now, const TimeBase &timeBase, std::vector<Event> &out)
+    {
+        render(now, now + 1, timeBase, out);
+    }
+
+    // Appends every event due in [from, to) to out, in tick order. A track only
+    // touches its own patterns, so different tracks may render concurrently.
+    void render(Tick from, Tick to, const TimeBase &timeBase, std::vector<Event> &out)
+    {
+        if (isFinished || !notes) return;
+        renderEvents(from, to, timeBase, out);
+    }
+
+    // As render(), also accumulating the time taken into this track's stats.
+    void renderTimed(Tick from, Tick to, const TimeBase &timeBase, std::vector<Event> &out)
     {
-        if (!isFinished)
+        if (isFinished || !notes) return;
+        auto begin = std::chrono::steady_clock::now();
+        renderEvents(from, to, timeBase, out);
+        auto nanos = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+        evaluations.fetch_add(1, std::memory_order_relaxed);
+        evaluationNanos.fetch_add(nanos, std::memory_order_relaxed);
+        if (nanos > maxEvaluationNanos.load(std::memory_order_relaxed))
         {
-            std::cout << "Track [" << name << "] ticked." << std::endl;
+            maxEvaluationNanos.store(nanos, std::memory_order_relaxed);
         }
     }
 
+    TrackStats stats() const
+    {
+        return TrackStats{id, name, evaluations.load(std::memory_order_relaxed),
+                          evaluationNanos.load(std::memory_order_relaxed),
+                          maxEvaluationNanos.load(std::memory_order_relaxed)};
+    }
+
+    // Rewinds the track's patterns to the start of the piece.
+    void reset()
+    {
+        if (notes) notes->reset();
+        if (velocities) velocities->reset();
+        if (durations) durations->reset();
+        nextEventTick = 0;
+        isFinished = false;
+    }
+
     void finish()
     {
         isFinished = true;
@@ -94,19 +228,124 @@ public:
         return name;
     }
 
+    int getId() const
+    {
+        return id;
+    }
+
+    void setId(int newId)
+    {
+        id = newId;
+    }
+
+    int getChannel() const
+    {
+        return channel;
+    }
+
+    // MIDI channel (0-15) stamped on this track's events.
+    void setChannel(int newChannel)
+    {
+        if (newChannel < 0 || newChannel > 15)
+            throw std::out_of_range("MIDI channel must be in the range 0-15");
+        channel = newChannel;
+    }
+
+    // Gives the track a fixed pool of voices per channel, allocated here so
+    // that note-ons and note-offs on the clock thread never allocate. Used
+    // when the timeline has a voice output attached.
+    void setVoices(int voicesPerChannel, StealPolicy policy = StealPolicy::Oldest)
+    {
+        voices = std::make_unique<VoiceAllocator>(voicesPerChannel, policy);
+    }
+
+    VoiceAllocator *getVoices() const
+    {
+        return voices.get();
+    }
+
+    void save(StateWriter &out) const
+    {
+        out.tag("TRAK");
+        out.write(id);
+        out.write(nextEventTick);
+        out.write(isFinished);
+        for (const auto &pattern : {notes, velocities, durations})
+        {
+            if (pattern) pattern->save(out);
+        }
+    }
+
+    // Voices still sounding belong to the state being replaced; they are
+    // dropped without note-offs (Timeline::loadState sends those first).
+    void load(StateReader &in)
+    {
+        if (voices) voices->releaseAll(0, [](const VoiceEvent &) {});
+        in.tag("TRAK");
+        if (in.read<int>() != id)
+            throw std::runtime_error("Snapshot does not match graph: track " + name);
+        in.read(nextEventTick);
+        in.read(isFinished);
+        for (const auto &pattern : {notes, velocities, durations})
+        {
+            if (pattern) pattern->load(in);
+        }
+    }
+
 private:
+    void renderEvents(Tick from, Tick to, const TimeBase &timeBase, std::vector<Event> &out)
+    {
+        if (nextEventTick < from) nextEventTick = from;
+
+        while (nextEventTick < to)
+        {
+            Event event;
+            try
+            {
+                event.note = static_cast<int>(notes->next());
+                event.velocity = velocities ? static_cast<int>(velocities->next()) : 64;
+                event.duration = timeBase.beatsToTicks(durations ? durations->next() : 1.0);
+            }
+            catch (const std::out_of_range &)
+            {
+                finish();
+                return;
+            }
+
+            event.tick = nextEventTick;
+            event.track = id;
+            event.channel = channel;
+            out.push_back(event);
+            nextEventTick += std::max<Tick>(1, event.duration);
+        }
+    }
+
     std::string name;
+    std::shared_ptr<Pattern> notes;
+    std::shared_ptr<Pattern> velocities;
+    std::shared_ptr<Pattern> durations;
+    int id;
+    int channel;
+    Tick nextEventTick;
     bool isFinished;
+    std::atomic<std::uint64_t> evaluations;
+    std::atomic<std::uint64_t> evaluationNanos;
+    std::atomic<std::uint64_t> maxEvaluationNanos;
+    std::unique_ptr<VoiceAllocator> voices;
 };
 
 class Timeline
 {
 public:
     Timeline(double tempo = 120.0, int ticksPerBeat = 480)
-        : tempo(tempo), ticksPerBeat(ticksPerBeat), running(false)
+        : Timeline(TimeBase(tempo, ticksPerBeat)) {}
+
+    explicit Timeline(const TimeBase &timeBase)
+        : timeBase(timeBase), running(false), currentTick(0), nextTrackId(0),
+          processFrame(0), processRate(0), pendingTicks(0), trackTiming(false)
     {
-        // clock = std::make_shared<Clock>(tempo, ticksPerBeat);
-        // clock->attachTarget([this]() { tick(); });
+        clock = std::make_shared<Clock>(timeBase);
+        clock->attachTarget([this]() { tick(); });
     }
 
     ~Timeline()
@@ -126,36 +365,403 @@ public:
         if (!running) return;
         running = false;
         clock->stop();
+        std::lock_guard<RtMutex> lock(mutex);
+        pendingTicks.store(0, std::memory_order_relaxed);
+        releaseVoices();
     }
 
     void addTrack(const std::shared_ptr<Track> &track)
     {
-        std::lock_guard<std::mutex> lock(mutex);
+        std::lock_guard<RtMutex> lock(mutex);
+        track->setId(nextTrackId++);
         tracks.push_back(track);
     }
 
+    void attachOutput(const std::function<void(const Event &)> &callback)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        outputCallback = callback;
+    }
+
+    // Receives note-on/note-off pairs from tracks with voices (Track::setVoices)
+    // as the timeline advances through tick(), render() or process(): notes
+    // end after their duration, or earlier when stolen or retriggered, and
+    // everything still sounding is released on stop(), seek() and loadState().
+    void attachVoiceOutput(const std::function<void(const VoiceEvent &)> &callback)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        voiceCallback = callback;
+    }
+
+    // Tracks are evaluated on this pool when set; pass nullptr to go back to
+    // evaluating them serially on the calling thread. Handing a tick to the
+    // pool is not real-time safe: parallelFor() allocates its task and takes
+    // the pool's locks. A clock-driven timeline trades that for spreading a
+    // tick over several cores, so the work is left out of RtScope checking.
+    void setThreadPool(const std::shared_ptr<ThreadPool> &newPool)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        pool = newPool;
+    }
+
+    // Per-track evaluation timing costs two clock reads per track and tick, so
+    // it is off unless asked for.
+    void setTrackTiming(bool enabled)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        trackTiming = enabled;
+    }
+
+    // Runs on the clock thread, which must not block: when another thread holds
+    // the timeline, the tick is left pending and played, late, by the next one.
     void tick()
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        for (auto &track : tracks)
+        pendingTicks.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<RtMutex> lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock()) return;
+        for (int due = pendingTicks.exchange(0, std::memory_order_relaxed); due > 0; --due)
+        {
+            advance();
+        }
+    }
+
+    // Offline rendering: evaluates the next numTicks ticks without the clock and
+    // appends the resulting events to out instead of dispatching them. Finished
+    // tracks are kept so that seek() can replay them. Voice events for the span
+    // go to the voice output, in tick order, before render() returns.
+    void render(Tick numTicks, std::vector<Event> &out)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        evaluate(currentTick, currentTick + numTicks, events);
+        if (voiceCallback) deliverVoices(currentTick, currentTick + numTicks);
+        currentTick += numTicks;
+        out.insert(out.end(), events.begin(), events.end());
+    }
+
+    // External drive for audio hosts: advances the timeline by exactly the
+    // (fractional) number of ticks spanned by numFrames at sampleRate and
+    // appends the events that fall inside the block with their frame offsets.
+    // Uses no thread; the host's audio callback is the clock. Voice events go
+    // to the voice output as in render().
+    void process(int numFrames, double sampleRate, std::vector<BlockEvent> &out)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        const std::int64_t rate = std::llround(sampleRate);
+
+        // The frame counter is tied to the tick position; re-derive it when the
+        // rate changes or after a seek.
+        if (rate != processRate)
+        {
+            processRate = rate;
+            processFrame = timeBase.ticksToFrames(currentTick, rate);
+        }
+
+        const std::int64_t blockEnd = processFrame + numFrames;
+        const Tick endTick = std::max(currentTick, timeBase.framesToTicks(blockEnd, rate));
+
+        if (endTick > currentTick)
         {
-            if (!track->finished())
+            evaluate(currentTick, endTick, events);
+            if (voiceCallback) deliverVoices(currentTick, endTick);
+            currentTick = endTick;
+            for (const auto &event : events)
             {
-                track->tick();
+                std::int64_t frame = timeBase.ticksToFrames(event.tick, rate);
+                out.push_back(BlockEvent{event, static_cast<int>(frame - processFrame)});
             }
         }
+        processFrame = blockEnd;
+    }
+
+    // Moves the playhead to an arbitrary tick by resetting every track and
+    // replaying (and discarding) the events before it.
+    void seek(Tick tick)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        releaseVoices();
+        for (auto &track : tracks)
+        {
+            track->reset();
+        }
+        currentTick = 0;
+        processRate = 0;
+        if (tick > 0)
+        {
+            evaluate(0, tick, events);
+            currentTick = tick;
+        }
+    }
+
+    Tick getCurrentTick() const
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        return currentTick;
+    }
+
+    // The playhead and every track's pattern state. To fork variations, build
+    // each copy of the timeline the same way and load the one snapshot into it.
+    Snapshot saveState() const
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        return save();
+    }
+
+    // Restores a snapshot from saveState(); the tracks must have been added in
+    // the same order with the same patterns. Sounding voices are released
+    // first. If the snapshot does not fit, the timeline is left as it was.
+    void loadState(std::span<const std::uint8_t> snapshot)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        releaseVoices();
+        Snapshot backup = save();
+        try
+        {
+            load(snapshot);
+        }
+        catch (...)
+        {
+            load(backup);
+            throw;
+        }
+    }
+
+    // Changes the tempo from the next tick on, for the clock, for schedulers
+    // reading getTimeBase() and for note durations. process() re-derives its
+    // frame position from the current tick at the new tempo.
+    void setTempo(double tempo)
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        timeBase = TimeBase(tempo, timeBase.getTicksPerBeat());
+        clock->setTempo(tempo);
+        processRate = 0;
+    }
+
+    // The current time base; safe to call from any thread without locking.
+    TimeBase getTimeBase() const
+    {
+        return clock->getTimeBase();
+    }
+
+    double getTempo() const
+    {
+        return getTimeBase().getTempo();
+    }
+
+    int getTicksPerBeat() const
+    {
+        return getTimeBase().getTicksPerBeat();
+    }
+
+    ClockStats clockStats() const
+    {
+        return clock->stats();
+    }
+
+    TimelineStats stats() const
+    {
+        std::lock_guard<RtMutex> lock(mutex);
+        TimelineStats result{tickTime.snapshot(), {}};
+        if (trackTiming)
+        {
+            for (const auto &track : tracks) result.tracks.push_back(track->stats());
+        }
+        return result;
+    }
+
+    void resetStats()
+    {
+        tickTime.reset();
+        clock->resetStats();
+    }
+
+private:
+    Snapshot save() const
+    {
+        StateWriter out;
+        out.tag("TMLN");
+        out.write(currentTick);
+        out.write(processFrame);
+        out.write(processRate);
+        out.write<std::uint32_t>(static_cast<std::uint32_t>(tracks.size()));
+        for (const auto &track : tracks)
+        {
+            track->save(out);
+        }
+        return out.take();
+    }
+
+    void load(std::span<const std::uint8_t> snapshot)
+    {
+        StateReader in(snapshot);
+        in.tag("TMLN");
+        Tick tick = in.read<Tick>();
+        std::int64_t frame = in.read<std::int64_t>();
+        std::int64_t rate = in.read<std::int64_t>();
+        if (in.read<std::uint32_t>() != tracks.size())
+            throw std::runtime_error("Snapshot does not match graph: track count");
+        for (auto &track : tracks)
+        {
+            track->load(in);
+        }
+        if (in.remaining())
+            throw std::runtime_error("Snapshot does not match graph: trailing data");
+        currentTick = tick;
+        processFrame = frame;
+        processRate = rate;
+    }
+
+    // One tick of tick(): evaluate, hand out voices, dispatch.
+    void advance()
+    {
+        auto begin = std::chrono::steady_clock::now();
+        evaluate(currentTick, currentTick + 1, events);
+        if (voiceCallback) allocateVoices(currentTick, currentTick + 1, voiceCallback);
+        currentTick++;
+
+        for (const auto &event : events)
+        {
+            dispatch(event);
+        }
+
+        // Finished tracks stay until their last notes have been released.
         tracks.erase(std::remove_if(tracks.begin(), tracks.end(),
-                                    [](const std::shared_ptr<Track> &track) { return track->finished(); }),
+                                    [](const std::shared_ptr<Track> &track)
+                                    {
+                                        return track->finished() && (!track->getVoices() || !track->getVoices()->active());
+                                    }),
                      tracks.end());
+        tickTime.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()));
     }
 
-private:
-    double tempo;
-    int ticksPerBeat;
+    // Renders [from, to) into per-track buffers, possibly in parallel, then
+    // merges them ordered by (tick, track id). Tracks are kept in id order and
+    // each buffer is already tick-sorted, so a stable sort of the concatenation
+    // gives the same sequence for any number of threads.
+    void evaluate(Tick from, Tick to, std::vector<Event> &merged)
+    {
+        if (trackEvents.size() < tracks.size())
+        {
+            trackEvents.resize(tracks.size());
+        }
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            trackEvents[i].clear();
+        }
+
+        auto renderTrack = [&](size_t i)
+        {
+            if (trackTiming)
+                tracks[i]->renderTimed(from, to, timeBase, trackEvents[i]);
+            else
+                tracks[i]->render(from, to, timeBase, trackEvents[i]);
+        };
+        if (pool && tracks.size() > 1)
+        {
+            RtExempt pooled; // see setThreadPool()
+            pool->parallelFor(tracks.size(), renderTrack);
+        }
+        else
+        {
+            for (size_t i = 0; i < tracks.size(); ++i) renderTrack(i);
+        }
+
+        merged.clear();
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            merged.insert(merged.end(), trackEvents[i].begin(), trackEvents[i].end());
+        }
+        if (to - from > 1)
+        {
+            std::stable_sort(merged.begin(), merged.end(),
+                             [](const Event &a, const Event &b) { return a.tick < b.tick; });
+        }
+
+    }
+
+    // Walks each voiced track's events for [from, to): releases the notes that
+    // have ended before each note-on, then those ending inside the span.
+    template <typename Out>
+    void allocateVoices(Tick from, Tick to, const Out &out)
+    {
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            VoiceAllocator *voices = tracks[i]->getVoices();
+            if (!voices) continue;
+            int id = tracks[i]->getId();
+            auto emit = [&out, id](VoiceEvent event)
+            {
+                event.track = id;
+                out(event);
+            };
+            voices->releaseUntil(from, emit);
+            for (const Event &event : trackEvents[i])
+            {
+                if (event.velocity <= 0) continue;
+                voices->releaseUntil(event.tick, emit);
+                voices->noteOn(event.tick, event.channel, event.note, event.velocity, event.duration, emit);
+            }
+            voices->releaseUntil(to - 1, emit);
+        }
+    }
+
+    // For spans of more than one tick: each track's voice events are in tick
+    // order, so collect them all and merge before handing them out.
+    void deliverVoices(Tick from, Tick to)
+    {
+        voiceEvents.clear();
+        allocateVoices(from, to, [this](const VoiceEvent &event) { voiceEvents.push_back(event); });
+        std::stable_sort(voiceEvents.begin(), voiceEvents.end(),
+                         [](const VoiceEvent &a, const VoiceEvent &b) { return a.tick < b.tick; });
+        for (const VoiceEvent &event : voiceEvents) voiceCallback(event);
+    }
+
+    void releaseVoices()
+    {
+        if (!voiceCallback) return;
+        for (auto &track : tracks)
+        {
+            if (VoiceAllocator *voices = track->getVoices())
+            {
+                int id = track->getId();
+                voices->releaseAll(currentTick, [this, id](VoiceEvent event)
+                {
+                    event.track = id;
+                    voiceCallback(event);
+                });
+            }
+        }
+    }
+
+    void dispatch(const Event &event)
+    {
+        ISOBAR_TRACE_DEBUG("dispatch", event);
+        if (outputCallback)
+        {
+            outputCallback(event);
+            return;
+        }
+        ISOBAR_TRACE_INFO("note (no output attached)", event);
+    }
+
+    TimeBase timeBase;
     std::atomic<bool> running;
+    Tick currentTick;
+    int nextTrackId;
+    std::int64_t processFrame;
+    std::int64_t processRate;
+    std::atomic<int> pendingTicks;
     std::shared_ptr<Clock> clock;
+    std::shared_ptr<ThreadPool> pool;
     std::vector<std::shared_ptr<Track>> tracks;
-    mutable std::mutex mutex;
+    std::vector<std::vector<Event>> trackEvents;
+    std::vector<Event> events;
+    std::vector<VoiceEvent> voiceEvents;
+    std::function<void(const Event &)> outputCallback;
+    std::function<void(const VoiceEvent &)> voiceCallback;
+    bool trackTiming;
+    Histogram tickTime;
+    mutable RtMutex mutex;
 };
 
 #endif
@@ -0,0 +1,271 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#include "RingBuffer.h"
+#include "Time.h"
+
+// Compile-time trace level: 0 = off, 1 = errors, 2 = info, 3 = debug. Trace
+// points above this level expand to nothing, arguments included.
+#ifndef ISOBAR_TRACE_LEVEL
+#define ISOBAR_TRACE_LEVEL 2
+#endif
+
+enum class TraceLevel : std::uint8_t
+{
+    Error = 1,
+    Info = 2,
+    Debug = 3
+};
+
+// Fixed-size binary record written on the hot path. message must be a string
+// literal (or otherwise outlive the tracer); it is formatted on the drain thread.
+struct TraceRecord
+{
+    std::int64_t timestamp; // steady clock, nanoseconds
+    const char *message;
+    Tick tick;
+    Tick duration;
+    std::int32_t track;
+    std::int16_t note;
+    std::int16_t velocity;
+    std::uint32_t thread;
+    TraceLevel level;
+};
+
+// Asynchronous tracer. Every thread that records gets its own lock-free SPSC
+// ring, so record() is a timestamp and a few stores; a background thread
+// drains all rings, orders each batch by timestamp and writes text to a file.
+// A thread's ring is allocated the first time it records; real-time threads
+// should call registerThread() up front so that never happens on the hot path.
+class Tracer
+{
+public:
+    static Tracer &instance()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    ~Tracer()
+    {
+        stop();
+    }
+
+    void start(const std::string &path, size_t ringCapacity = 4096)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (active) return;
+        file = std::fopen(path.c_str(), "w");
+        if (!file)
+            throw std::runtime_error("Could not open trace file: " + path);
+        std::setvbuf(file, nullptr, _IOFBF, 1 << 16);
+        capacity = ringCapacity;
+        running = true;
+        active.store(true, std::memory_order_release);
+        drainer = std::thread(&Tracer::drainLoop, this);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            if (!active) return;
+            active.store(false, std::memory_order_release);
+            running = false;
+        }
+        drainer.join();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    // Records with a level above this are ignored at run time.
+    void setLevel(TraceLevel level)
+    {
+        maxLevel.store(static_cast<std::uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    void registerThread()
+    {
+        local();
+    }
+
+    void record(TraceLevel level, const char *message, std::int32_t track = -1, Tick tick = 0,
+                int note = 0, int velocity = 0, Tick duration = 0)
+    {
+        if (!active.load(std::memory_order_acquire) ||
+            static_cast<std::uint8_t>(level) > maxLevel.load(std::memory_order_relaxed))
+            return;
+
+        ThreadBuffer &buffer = local();
+        TraceRecord entry;
+        entry.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch()).count();
+        entry.message = message;
+        entry.tick = tick;
+        entry.duration = duration;
+        entry.track = track;
+        entry.note = static_cast<std::int16_t>(note);
+        entry.velocity = static_cast<std::int16_t>(velocity);
+        entry.thread = buffer.id;
+        entry.level = level;
+        if (!buffer.ring.push(entry))
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename EventType>
+    void record(TraceLevel level, const char *message, const EventType &event)
+    {
+        record(level, message, event.track, event.tick, event.note, event.velocity, event.duration);
+    }
+
+    // Records lost because a thread's ring was full.
+    unsigned long getDropped() const
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        unsigned long total = retiredDrops;
+        for (const auto &buffer : buffers) total += buffer->dropped.load(std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    struct ThreadBuffer
+    {
+        ThreadBuffer(size_t capacity, std::uint32_t id) : ring(capacity), id(id), dropped(0), closed(false) {}
+
+        RingBuffer<TraceRecord> ring;
+        std::uint32_t id;
+        std::atomic<unsigned long> dropped;
+        std::atomic<bool> closed; // owning thread has exited
+    };
+
+    // Marks the ring closed when its thread exits; the drainer frees it once empty.
+    struct LocalHandle
+    {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~LocalHandle()
+        {
+            if (buffer) buffer->closed.store(true, std::memory_order_release);
+        }
+    };
+
+    Tracer() : active(false), running(false), maxLevel(3), file(nullptr), capacity(4096), nextThreadId(0), retiredDrops(0) {}
+
+    ThreadBuffer &local()
+    {
+        thread_local LocalHandle handle;
+        if (!handle.buffer)
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            handle.buffer = std::make_shared<ThreadBuffer>(capacity, nextThreadId++);
+            buffers.push_back(handle.buffer);
+        }
+        return *handle.buffer;
+    }
+
+    void drainLoop()
+    {
+        std::vector<TraceRecord> batch;
+        std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+        bool more = true;
+        while (more)
+        {
+            more = running;
+            {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                snapshot = buffers;
+            }
+
+            batch.clear();
+            for (const auto &buffer : snapshot)
+            {
+                TraceRecord entry;
+                while (buffer->ring.pop(entry)) batch.push_back(entry);
+            }
+            std::sort(batch.begin(), batch.end(),
+                      [](const TraceRecord &a, const TraceRecord &b) { return a.timestamp < b.timestamp; });
+            for (const auto &entry : batch) write(entry);
+            if (!batch.empty()) std::fflush(file);
+
+            retireClosed();
+            if (more) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void retireClosed()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto it = buffers.begin(); it != buffers.end();)
+        {
+            if ((*it)->closed.load(std::memory_order_acquire) && (*it)->ring.size() == 0)
+            {
+                retiredDrops += (*it)->dropped.load(std::memory_order_relaxed);
+                it = buffers.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void write(const TraceRecord &entry)
+    {
+        static const char *levels[] = {"", "ERROR", "INFO", "DEBUG"};
+        std::fprintf(file, "%lld.%09lld %-5s thread=%u %s", static_cast<long long>(entry.timestamp / 1000000000),
+                     static_cast<long long>(entry.timestamp % 1000000000), levels[static_cast<int>(entry.level)],
+                     entry.thread, entry.message);
+        if (entry.track >= 0)
+        {
+            std::fprintf(file, " track=%d tick=%lld note=%d velocity=%d duration=%lld", entry.track,
+                         static_cast<long long>(entry.tick), entry.note, entry.velocity,
+                         static_cast<long long>(entry.duration));
+        }
+        std::fputc('\n', file);
+    }
+
+    std::atomic<bool> active;
+    std::atomic<bool> running;
+    std::atomic<std::uint8_t> maxLevel;
+    std::FILE *file;
+    size_t capacity;
+    std::uint32_t nextThreadId;
+    unsigned long retiredDrops;
+    std::thread drainer;
+    mutable std::mutex registryMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+#if ISOBAR_TRACE_LEVEL >= 1
+#define ISOBAR_TRACE_ERROR(...) Tracer::instance().record(TraceLevel::Error, __VA_ARGS__)
+#else
+#define ISOBAR_TRACE_ERROR(...) ((void)0)
+#endif
+
+#if ISOBAR_TRACE_LEVEL >= 2
+#define ISOBAR_TRACE_INFO(...) Tracer::instance().record(TraceLevel::Info, __VA_ARGS__)
+#else
+#define ISOBAR_TRACE_INFO(...) ((void)0)
+#endif
+
+#if ISOBAR_TRACE_LEVEL >= 3
+#define ISOBAR_TRACE_DEBUG(...) Tracer::instance().record(TraceLevel::Debug, __VA_ARGS__)
+#else
+#define ISOBAR_TRACE_DEBUG(...) ((void)0)
+#endif
+
+#endif // TRACE_H
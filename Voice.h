@@ -0,0 +1,328 @@
+#ifndef VOICE_H
+#define VOICE_H
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Time.h"
+
+// What to do with a note-on when every voice is sounding.
+enum class StealPolicy
+{
+    None,       // drop the new note
+    Oldest,     // release the voice that started first
+    SoonestEnd, // release the voice due to end first
+    Quietest,   // release the lowest velocity (oldest on ties)
+    Lowest,     // release the lowest note
+    Highest     // release the highest note
+};
+
+// A note-on or note-off addressed to one voice of a pool.
+struct VoiceEvent
+{
+    Tick tick;
+    int track;
+    int channel;
+    int note;
+    int velocity; // 0 for note-off
+    int voice;
+    bool on;
+};
+
+// A fixed set of voices for one channel. Everything is allocated in the
+// constructor: voices sit in an array, free ones on a stack, sounding ones on
+// an age-ordered intrusive list and in an indexed min-heap of end ticks, and
+// a 128-entry table maps each note to its voice. Note-off matching, starting
+// a voice and stealing the oldest or soonest-ending voice are O(1) (plus
+// O(log n) heap upkeep); the other policies scan the sounding voices. A note
+// that is already sounding is released and retriggered, so each note holds
+// at most one voice.
+class VoicePool
+{
+public:
+    static constexpr Tick Held = std::numeric_limits<Tick>::max();
+
+    VoicePool(int capacity, StealPolicy policy = StealPolicy::Oldest, int channel = 0)
+        : voices(capacity), heap(capacity), policy(policy), channel(channel), numActive(0),
+          oldest(-1), newest(-1), stolen(0), dropped(0)
+    {
+        if (capacity <= 0)
+            throw std::invalid_argument("Voice pool must have at least one voice");
+        free.reserve(capacity);
+        for (int v = capacity - 1; v >= 0; --v) free.push_back(v);
+        for (int &entry : byNote) entry = -1;
+    }
+
+    // Starts note until tick end (Held: until noteOff) and returns its voice,
+    // or -1 if it was dropped. out receives any note-off this forces first.
+    template <typename Out>
+    int noteOn(Tick tick, int note, int velocity, Tick end, Out &&out)
+    {
+        note &= 0x7f;
+        if (byNote[note] >= 0) release(byNote[note], tick, out);
+        if (free.empty())
+        {
+            int victim = chooseVictim();
+            if (victim < 0)
+            {
+                dropped++;
+                return -1;
+            }
+            release(victim, tick, out);
+            stolen++;
+        }
+
+        int v = free.back();
+        free.pop_back();
+        Voice &voice = voices[v];
+        voice.note = note;
+        voice.velocity = velocity;
+        voice.end = end;
+        voice.prev = newest;
+        voice.next = -1;
+        if (newest >= 0)
+            voices[newest].next = v;
+        else
+            oldest = v;
+        newest = v;
+        byNote[note] = v;
+        heapPush(v);
+        numActive++;
+        out(VoiceEvent{tick, 0, channel, note, velocity, v, true});
+        return v;
+    }
+
+    // Releases note if it is sounding; returns whether it was.
+    template <typename Out>
+    bool noteOff(Tick tick, int note, Out &&out)
+    {
+        int v = byNote[note & 0x7f];
+        if (v < 0) return false;
+        release(v, tick, out);
+        return true;
+    }
+
+    // Releases, in end order, every voice due to end at or before upTo.
+    template <typename Out>
+    void releaseUntil(Tick upTo, Out &&out)
+    {
+        while (numActive && voices[heap[0]].end <= upTo)
+        {
+            release(heap[0], voices[heap[0]].end, out);
+        }
+    }
+
+    template <typename Out>
+    void releaseAll(Tick tick, Out &&out)
+    {
+        while (oldest >= 0) release(oldest, tick, out);
+    }
+
+    // The voice sounding note, or -1.
+    int voiceFor(int note) const
+    {
+        return byNote[note & 0x7f];
+    }
+
+    int active() const
+    {
+        return numActive;
+    }
+
+    int capacity() const
+    {
+        return static_cast<int>(voices.size());
+    }
+
+    std::uint64_t getStolen() const
+    {
+        return stolen;
+    }
+
+    std::uint64_t getDropped() const
+    {
+        return dropped;
+    }
+
+private:
+    struct Voice
+    {
+        int note = 0;
+        int velocity = 0;
+        Tick end = 0;
+        int prev = -1;
+        int next = -1;
+        int heapIndex = -1;
+    };
+
+    template <typename Out>
+    void release(int v, Tick tick, Out &out)
+    {
+        Voice &voice = voices[v];
+        out(VoiceEvent{tick, 0, channel, voice.note, 0, v, false});
+        if (voice.prev >= 0)
+            voices[voice.prev].next = voice.next;
+        else
+            oldest = voice.next;
+        if (voice.next >= 0)
+            voices[voice.next].prev = voice.prev;
+        else
+            newest = voice.prev;
+        heapRemove(v);
+        byNote[voice.note] = -1;
+        free.push_back(v);
+        numActive--;
+    }
+
+    int chooseVictim() const
+    {
+        switch (policy)
+        {
+        case StealPolicy::None:
+            return -1;
+        case StealPolicy::Oldest:
+            return oldest;
+        case StealPolicy::SoonestEnd:
+            return heap[0];
+        default:
+            break;
+        }
+        int best = oldest;
+        for (int v = voices[oldest].next; v >= 0; v = voices[v].next)
+        {
+            const Voice &a = voices[v], &b = voices[best];
+            if ((policy == StealPolicy::Quietest && a.velocity < b.velocity) ||
+                (policy == StealPolicy::Lowest && a.note < b.note) ||
+                (policy == StealPolicy::Highest && a.note > b.note))
+            {
+                best = v;
+            }
+        }
+        return best;
+    }
+
+    bool earlier(int a, int b) const
+    {
+        return voices[a].end < voices[b].end;
+    }
+
+    void place(int index, int v)
+    {
+        heap[index] = v;
+        voices[v].heapIndex = index;
+    }
+
+    void heapPush(int v)
+    {
+        place(numActive, v);
+        siftUp(numActive);
+    }
+
+    void heapRemove(int v)
+    {
+        int index = voices[v].heapIndex;
+        int last = heap[numActive - 1];
+        voices[v].heapIndex = -1;
+        if (last == v) return;
+        place(index, last);
+        siftUp(index);
+        siftDown(voices[last].heapIndex, numActive - 1);
+    }
+
+    void siftUp(int index)
+    {
+        int v = heap[index];
+        while (index > 0)
+        {
+            int parent = (index - 1) / 2;
+            if (!earlier(v, heap[parent])) break;
+            place(index, heap[parent]);
+            index = parent;
+        }
+        place(index, v);
+    }
+
+    void siftDown(int index, int size)
+    {
+        int v = heap[index];
+        while (true)
+        {
+            int child = 2 * index + 1;
+            if (child >= size) break;
+            if (child + 1 < size && earlier(heap[child + 1], heap[child])) child++;
+            if (!earlier(heap[child], v)) break;
+            place(index, heap[child]);
+            index = child;
+        }
+        place(index, v);
+    }
+
+    std::vector<Voice> voices;
+    std::vector<int> heap;
+    std::vector<int> free;
+    int byNote[128];
+    StealPolicy policy;
+    int channel;
+    int numActive;
+    int oldest;
+    int newest;
+    std::uint64_t stolen;
+    std::uint64_t dropped;
+};
+
+// One VoicePool per MIDI channel, all built up front.
+class VoiceAllocator
+{
+public:
+    VoiceAllocator(int voicesPerChannel, StealPolicy policy = StealPolicy::Oldest)
+    {
+        pools.reserve(16);
+        for (int channel = 0; channel < 16; ++channel) pools.emplace_back(voicesPerChannel, policy, channel);
+    }
+
+    // Starts a note lasting duration ticks (VoicePool::Held: until noteOff).
+    template <typename Out>
+    int noteOn(Tick tick, int channel, int note, int velocity, Tick duration, Out &&out)
+    {
+        Tick end = duration == VoicePool::Held ? VoicePool::Held : tick + duration;
+        return pools[channel & 0x0f].noteOn(tick, note, velocity, end, out);
+    }
+
+    template <typename Out>
+    bool noteOff(Tick tick, int channel, int note, Out &&out)
+    {
+        return pools[channel & 0x0f].noteOff(tick, note, out);
+    }
+
+    template <typename Out>
+    void releaseUntil(Tick upTo, Out &&out)
+    {
+        for (auto &pool : pools) pool.releaseUntil(upTo, out);
+    }
+
+    template <typename Out>
+    void releaseAll(Tick tick, Out &&out)
+    {
+        for (auto &pool : pools) pool.releaseAll(tick, out);
+    }
+
+    VoicePool &channel(int channel)
+    {
+        return pools[channel & 0x0f];
+    }
+
+    int active() const
+    {
+        int total = 0;
+        for (const auto &pool : pools) total += pool.active();
+        return total;
+    }
+
+private:
+    std::vector<VoicePool> pools;
+};
+
+#endif // VOICE_H
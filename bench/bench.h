@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Keeps the compiler from discarding a value computed in a timed loop.
+template <typename T>
+inline void keep(const T &value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+// Thread counts for a scaling sweep: the powers of two below the core count,
+// then the core count itself (1, 2, 4, 6 on six cores).
+inline std::vector<unsigned> threadCounts()
+{
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) counts.push_back(threads);
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+struct BenchResult
+{
+    std::string suite;
+    std::string name;
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+// Collects named metrics from every benchmark and writes them as JSON or as
+// long-format CSV (suite,name,metric,value), one row per metric, so runs from
+// different releases can be diffed or loaded into a dataframe directly.
+class BenchReport
+{
+public:
+    void add(const std::string &suite, const std::string &name,
+             std::vector<std::pair<std::string, double>> metrics)
+    {
+        results.push_back(BenchResult{suite, name, std::move(metrics)});
+    }
+
+    // Times body() in a loop: the iteration count is calibrated to take about
+    // minSeconds / samples, then that many iterations are timed samples times.
+    // Reports the median and fastest sample per operation.
+    template <typename Body>
+    void measure(const std::string &suite, const std::string &name, Body body,
+                 double minSeconds = 0.2, int samples = 5)
+    {
+        using clock = std::chrono::steady_clock;
+        auto run = [&](std::uint64_t n)
+        {
+            auto begin = clock::now();
+            for (std::uint64_t i = 0; i < n; ++i) body();
+            return std::chrono::duration<double>(clock::now() - begin).count();
+        };
+
+        const double target = minSeconds / samples;
+        std::uint64_t iterations = 1;
+        double elapsed = run(iterations);
+        while (elapsed < target / 4)
+        {
+            iterations *= 2;
+            elapsed = run(iterations);
+        }
+        iterations = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(iterations * target / elapsed));
+
+        std::vector<double> perOp;
+        for (int s = 0; s < samples; ++s)
+        {
+            perOp.push_back(run(iterations) * 1e9 / iterations);
+        }
+        std::sort(perOp.begin(), perOp.end());
+        double median = perOp[perOp.size() / 2];
+        add(suite, name, {{"ns_per_op", median},
+                          {"ns_per_op_min", perOp.front()},
+                          {"ops_per_sec", median > 0 ? 1e9 / median : 0.0},
+                          {"iterations", static_cast<double>(iterations * samples)}});
+    }
+
+    void writeJson(std::ostream &out) const
+    {
+        out << "{\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto &result = results[i];
+            out << (i ? ",\n" : "\n") << "    {\"suite\": \"" << result.suite << "\", \"name\": \"" << result.name
+                << "\", \"metrics\": {";
+            for (size_t m = 0; m < result.metrics.size(); ++m)
+            {
+                out << (m ? ", " : "") << "\"" << result.metrics[m].first << "\": " << result.metrics[m].second;
+            }
+            out << "}}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void writeCsv(std::ostream &out) const
+    {
+        out << "suite,name,metric,value\n";
+        for (const auto &result : results)
+        {
+            for (const auto &metric : result.metrics)
+            {
+                out << result.suite << "," << result.name << "," << metric.first << "," << metric.second << "\n";
+            }
+        }
+    }
+
+private:
+    std::vector<BenchResult> results;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "bench.h"
+#include "../Cache.h"
+#include "../Operators.h"
+#include "../Sequence.h"
+
+// numTracks tracks playing the same transposed, looped riff, each rendering
+// one bar of numValues values: separate graphs versus graphs interned into
+// a BlockCache, where the riff is evaluated once and the tracks copy blocks.
+inline void benchCache(BenchReport &report, int numTracks = 64, size_t numValues = 4096)
+{
+    auto riff = []()
+    {
+        auto notes = std::make_shared<PLoop>(std::make_shared<PSequence>(std::vector<double>{0, 3, 5, 7, 10, 12, 10, 7}, 1));
+        auto accents = std::make_shared<PSequence>(std::vector<double>{1, 0, 0.5, 0});
+        return notes + 48 + accents * 12;
+    };
+
+    std::vector<std::shared_ptr<Pattern>> separate;
+    BlockCache cache(4096, 256);
+    std::vector<std::shared_ptr<Pattern>> shared;
+    for (int i = 0; i < numTracks; ++i)
+    {
+        separate.push_back(riff());
+        shared.push_back(cache.intern(riff()));
+    }
+
+    std::vector<double> out(numValues);
+    auto run = [&](const char *name, std::vector<std::shared_ptr<Pattern>> &tracks)
+    {
+        report.measure("cache", name, [&]()
+        {
+            for (auto &track : tracks)
+            {
+                track->reset();
+                keep(track->nextBlock(out.data(), out.size()));
+            }
+        }, 0.5, 3);
+    };
+    run("separate/nextBlock", separate);
+    run("interned/nextBlock", shared);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "bench.h"
+#include "../Sequence.h"
+#include "../Timeline.h"
+
+// Real-time run of a timeline on its own clock: wake-up lateness, callback time
+// and overruns from the clock's histograms.
+inline void benchClockJitter(BenchReport &report, double tempo = 120, int ticksPerBeat = 480, int seconds = 2)
+{
+    Timeline timeline(tempo, ticksPerBeat);
+    for (int i = 0; i < 16; ++i)
+    {
+        timeline.addTrack(std::make_shared<Track>("t" + std::to_string(i), std::make_shared<PSeries>(i, 1), nullptr,
+                                                  std::make_shared<PSequence>(std::vector<double>{0.25, 0.125})));
+    }
+    timeline.attachOutput([](const Event &event) { keep(event); });
+
+    timeline.start();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    timeline.stop();
+
+    ClockStats clock = timeline.clockStats();
+    TimelineStats ticks = timeline.stats();
+    report.add("clock", "jitter", {{"ticks", static_cast<double>(clock.ticks)},
+                                   {"overruns", static_cast<double>(clock.overruns)},
+                                   {"lateness_p50_ns", static_cast<double>(clock.lateness.percentile(0.5))},
+                                   {"lateness_p99_ns", static_cast<double>(clock.lateness.percentile(0.99))},
+                                   {"lateness_p999_ns", static_cast<double>(clock.lateness.percentile(0.999))},
+                                   {"lateness_max_ns", static_cast<double>(clock.lateness.max)},
+                                   {"callback_p50_ns", static_cast<double>(clock.callback.percentile(0.5))},
+                                   {"callback_p99_ns", static_cast<double>(clock.callback.percentile(0.99))},
+                                   {"tick_p99_ns", static_cast<double>(ticks.tick.percentile(0.99))}});
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "bench.h"
+#include "../Dict.h"
+#include "../Note.h"
+#include "../Sequence.h"
+
+// 256 note events per operation: zipping three patterns' next() into Notes
+// versus one PDict::nextBlock() into columns.
+inline void benchDict(BenchReport &report, size_t blockSize = 256)
+{
+    auto pitches = std::make_shared<PSequence>(std::vector<double>{60, 62, 64, 65, 67, 69, 71, 72});
+    auto velocities = std::make_shared<PSequence>(std::vector<double>{100, 80, 90, 70});
+    auto durations = std::make_shared<PSequence>(std::vector<double>{0.25, 0.25, 0.5});
+
+    std::shared_ptr<Pattern> pitch = pitches, velocity = velocities, duration = durations;
+    std::vector<Note> notes;
+    notes.reserve(blockSize);
+    report.measure("dict", "zip/next", [&]()
+    {
+        notes.clear();
+        for (size_t i = 0; i < blockSize; ++i)
+        {
+            notes.emplace_back(static_cast<int>(pitch->next()), static_cast<int>(velocity->next()), duration->next());
+        }
+        keep(notes);
+    });
+
+    PDict patterns(pitches, velocities, durations, 0.0);
+    NoteBlock block;
+    report.measure("dict", "pdict/patterns", [&]() { keep(patterns.nextBlock(block, blockSize)); });
+
+    PDict constants(pitches, 100.0, 0.25, 0.0);
+    report.measure("dict", "pdict/constants", [&]() { keep(constants.nextBlock(block, blockSize)); });
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "bench.h"
+#include "../Generator.h"
+#include "../Sequence.h"
+
+// A coroutine pattern against the hand-written state machines it replaces:
+// per-value next() through the Pattern interface, and restarting (reset plus
+// one value) which allocates and frees a coroutine frame each time.
+inline void benchGenerator(BenchReport &report, int numValues = 4096)
+{
+    std::shared_ptr<Pattern> series = std::make_shared<PSeries>(0, 1);
+    std::shared_ptr<Pattern> generatedSeries = std::make_shared<PGenerator>([]() -> Generator<double>
+    {
+        for (double v = 0;; v += 1) co_yield v;
+    });
+
+    std::vector<double> notes = {60, 62, 64, 65, 67, 69, 71, 72};
+    std::shared_ptr<Pattern> sequence = std::make_shared<PSequence>(notes);
+    std::shared_ptr<Pattern> generatedSequence = std::make_shared<PGenerator>([&notes]() -> Generator<double>
+    {
+        while (true)
+        {
+            for (double note : notes) co_yield note;
+        }
+    });
+
+    auto pull = [&](const char *name, std::shared_ptr<Pattern> &pattern)
+    {
+        report.measure("generator", name, [&]()
+        {
+            double sum = 0;
+            for (int i = 0; i < numValues; ++i) sum += pattern->next();
+            keep(sum);
+        });
+    };
+    pull("PSeries/next", series);
+    pull("PGenerator(series)/next", generatedSeries);
+    pull("PSequence/next", sequence);
+    pull("PGenerator(sequence)/next", generatedSequence);
+
+    auto restart = [&](const char *name, std::shared_ptr<Pattern> &pattern)
+    {
+        report.measure("generator", name, [&]()
+        {
+            double sum = 0;
+            for (int i = 0; i < numValues; ++i)
+            {
+                pattern->reset();
+                sum += pattern->next();
+            }
+            keep(sum);
+        });
+    };
+    restart("PSeries/reset", series);
+    restart("PGenerator(series)/reset", generatedSeries);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "../Markov.h"
+#include "../ThreadPool.h"
+
+// Training on a synthetic corpus of a few million notes, 1..N threads, then
+// sampling from the trained model.
+inline void benchMarkov(BenchReport &report, int order = 3, size_t numNotes = 4000000)
+{
+    std::mt19937 rng(1);
+    std::vector<std::vector<double>> corpus(16);
+    for (auto &sequence : corpus)
+    {
+        int note = 60;
+        for (size_t i = 0; i < numNotes / corpus.size(); ++i)
+        {
+            note = std::clamp(note + static_cast<int>(rng() % 9) - 4, 36, 96);
+            sequence.push_back(note);
+        }
+    }
+
+    std::shared_ptr<const MarkovModel> model;
+    for (unsigned threads : threadCounts())
+    {
+        std::unique_ptr<ThreadPool> pool;
+        if (threads > 1) pool = std::make_unique<ThreadPool>(threads - 1);
+        auto begin = std::chrono::steady_clock::now();
+        model = MarkovModel::train(corpus, order, pool.get());
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        report.add("markov", "train/threads=" + std::to_string(threads),
+                   {{"notes", static_cast<double>(numNotes)},
+                    {"states", static_cast<double>(model->numStates())},
+                    {"transitions", static_cast<double>(model->numTransitions())},
+                    {"seconds", seconds},
+                    {"notes_per_sec", numNotes / seconds}});
+    }
+
+    PMarkov markov(model, 1);
+    report.measure("markov", "PMarkov::next", [&markov]() { keep(markov.next()); });
+}
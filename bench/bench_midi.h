@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "bench.h"
+#include "../Sequence.h"
+#include "../MidiWriter.h"
+
+// Streams an offline render of many tracks into a type 0 file.
+inline void benchMidiWriter(BenchReport &report, int numTracks = 64, Tick numTicks = 480 * 4000)
+{
+    const std::string path = "bench_writer.mid";
+    TimeBase base(120, 480);
+    Timeline timeline(base);
+    for (int i = 0; i < numTracks; ++i)
+    {
+        auto notes = std::make_shared<PLoop>(std::make_shared<PSeries>(36 + i % 48, 1, 12));
+        auto durations = std::make_shared<PSequence>(std::vector<double>{0.25, 0.125, 0.125, 0.5});
+        auto track = std::make_shared<Track>("track" + std::to_string(i), notes, nullptr, durations);
+        track->setChannel(i % 16);
+        timeline.addTrack(track);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::uint64_t bytes = 0, events = 0;
+    {
+        MidiWriter writer(path, base);
+        renderToMidi(timeline, numTicks, writer);
+        writer.close();
+        bytes = writer.bytesWritten();
+        events = writer.eventsWritten();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::remove(path.c_str());
+
+    report.add("midi", "writer/render+encode",
+               {{"notes", static_cast<double>(events)},
+                {"mb", bytes / 1e6},
+                {"mb_per_sec", bytes / 1e6 / seconds},
+                {"events_per_sec", events / seconds}});
+
+    // Encoding alone, from a pre-rendered block reused many times.
+    std::vector<Event> block;
+    Timeline source(base);
+    source.addTrack(std::make_shared<Track>("t", std::make_shared<PSeries>(0, 1), nullptr,
+                                            std::make_shared<PSequence>(std::vector<double>{0.0625})));
+    source.render(480 * 1000, block);
+
+    begin = std::chrono::steady_clock::now();
+    {
+        MidiWriter writer(path, base);
+        for (int pass = 0; pass < 50; ++pass)
+        {
+            Tick offset = pass * 480 * 1000;
+            for (auto event : block)
+            {
+                event.tick += offset;
+                writer.write(event);
+            }
+        }
+        writer.close();
+        bytes = writer.bytesWritten();
+        events = writer.eventsWritten();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::remove(path.c_str());
+
+    report.add("midi", "writer/encode",
+               {{"notes", static_cast<double>(events)},
+                {"mb_per_sec", bytes / 1e6 / seconds},
+                {"events_per_sec", events / seconds}});
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "bench.h"
+#include "../Osc.h"
+
+// Localhost round trip: queue time on the "clock thread" to arrival at the receiver.
+inline void benchOscLoopback(BenchReport &report, int numTicks = 2000, int eventsPerTick = 8)
+{
+    OscReceiver receiver;
+    OscOutput output("127.0.0.1", receiver.getPort());
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < numTicks; ++tick)
+    {
+        for (int i = 0; i < eventsPerTick; ++i)
+        {
+            output.send(Event{tick, i, 0, 60 + i, 100, 120});
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(250));
+    }
+    auto notes = receiver.waitFor(static_cast<size_t>(numTicks) * eventsPerTick, std::chrono::seconds(5));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<long long> latencies;
+    for (const auto &note : notes) latencies.push_back(note.latency.count());
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies.empty() ? 0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+
+    report.add("osc", "loopback",
+               {{"sent", static_cast<double>(numTicks) * eventsPerTick},
+                {"received", static_cast<double>(notes.size())},
+                {"events_per_sec", notes.size() / seconds},
+                {"bundles", static_cast<double>(output.getBundlesSent())},
+                {"send_calls", static_cast<double>(output.getSendCalls())},
+                {"latency_p50_ns", static_cast<double>(percentile(0.5))},
+                {"latency_p99_ns", static_cast<double>(percentile(0.99))}});
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "../Sequence.h"
+#include "../Operators.h"
+
+// Pattern::next() through the virtual interface, as Track calls it.
+inline void benchPatterns(BenchReport &report)
+{
+    std::vector<std::pair<std::string, std::shared_ptr<Pattern>>> patterns = {
+        {"PSequence", std::make_shared<PSequence>(std::vector<double>{60, 62, 64, 65, 67, 69, 71, 72})},
+        {"PSeries", std::make_shared<PSeries>(0, 1)},
+        {"PRange", std::make_shared<PRange>(0, 1e300, 1)},
+        {"PGeom", std::make_shared<PGeom>(1, 1.0000001)},
+        {"PImpulse", std::make_shared<PImpulse>(4)},
+        {"PLoop", std::make_shared<PLoop>(std::make_shared<PSeries>(0, 1, 16))},
+    };
+
+    for (const auto &entry : patterns)
+    {
+        Pattern &pattern = *entry.second;
+        report.measure("patterns", entry.first + "::next", [&pattern]() { keep(pattern.next()); });
+    }
+
+    // Exhaustion goes through an exception; measure a short pattern rewound each time.
+    auto shortSeries = std::make_shared<PSeries>(0, 1, 4);
+    report.measure("patterns", "PSeries::next+exhaust+reset", [&shortSeries]()
+    {
+        try
+        {
+            while (true) keep(shortSeries->next());
+        }
+        catch (const std::out_of_range &)
+        {
+            shortSeries->reset();
+        }
+    });
+
+    // A folded arithmetic chain and a two-pattern sum, 256 values per operation
+    // pulled one next() at a time versus one nextBlock().
+    const size_t blockSize = 256;
+    std::vector<double> block(blockSize);
+    auto chain = std::make_shared<PClamp>((std::make_shared<PSeries>(0, 1) * 0.5 + 3) * -2 + 100, 0, 127) / 127;
+    auto sum = std::make_shared<PSequence>(std::vector<double>{60, 62, 64, 65}) + std::make_shared<PSeries>(0, 1);
+    for (const auto &entry : {std::make_pair(std::string("affine_chain"), chain), std::make_pair(std::string("sum"), sum)})
+    {
+        Pattern &pattern = *entry.second;
+        report.measure("operators", entry.first + "/next", [&]()
+        {
+            for (size_t i = 0; i < blockSize; ++i) block[i] = pattern.next();
+            keep(block);
+        });
+        report.measure("operators", entry.first + "/nextBlock", [&]() { keep(pattern.nextBlock(block.data(), blockSize)); });
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include "bench.h"
+#include "../Rhythm.h"
+#include "../Sequence.h"
+
+// Finding the onsets of many sparse rhythmic tracks over a bar of 4096 steps:
+// stepping PImpulse/PRhythm one call per step versus jumping hit to hit.
+inline void benchRhythm(BenchReport &report, int numTracks = 1000, int barSteps = 4096)
+{
+    std::vector<PImpulse> impulses;
+    std::vector<PRhythm> rhythms;
+    for (int i = 0; i < numTracks; ++i)
+    {
+        impulses.emplace_back(16 + i % 48);
+        rhythms.emplace_back(RhythmMask::euclidean(1 + i % 5, 64 + i % 64, i));
+    }
+
+    report.measure("rhythm", "PImpulse/step", [&]()
+    {
+        int hits = 0;
+        for (auto &impulse : impulses)
+        {
+            for (int s = 0; s < barSteps; ++s) hits += impulse.next() != 0;
+        }
+        keep(hits);
+    }, 0.5, 3);
+
+    report.measure("rhythm", "PRhythm/step", [&]()
+    {
+        int hits = 0;
+        for (auto &rhythm : rhythms)
+        {
+            for (int s = 0; s < barSteps; ++s) hits += rhythm.next() != 0;
+        }
+        keep(hits);
+    }, 0.5, 3);
+
+    report.measure("rhythm", "PRhythm/skipToOnset", [&]()
+    {
+        int hits = 0;
+        for (auto &rhythm : rhythms)
+        {
+            for (int s = rhythm.skipToOnset(); s < barSteps; s += 1 + rhythm.skipToOnset())
+            {
+                rhythm.next();
+                hits++;
+            }
+        }
+        keep(hits);
+    }, 0.5, 3);
+
+    std::vector<double> block(barSteps);
+    report.measure("rhythm", "PRhythm/nextBlock", [&]()
+    {
+        for (auto &rhythm : rhythms) keep(rhythm.nextBlock(block.data(), block.size()));
+    }, 0.5, 3);
+}
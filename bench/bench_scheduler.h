@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "bench.h"
+#include "../Sequence.h"
+#include "../Scheduler.h"
+
+// Many independent timelines multiplexed over one scheduler thread.
+inline void benchScheduler(BenchReport &report, int numTimelines = 2000, int seconds = 1)
+{
+    std::vector<std::shared_ptr<Timeline>> timelines;
+    std::atomic<unsigned long> events(0);
+    Scheduler scheduler(1);
+
+    for (int i = 0; i < numTimelines; ++i)
+    {
+        auto timeline = std::make_shared<Timeline>(120 + i % 60, 24);
+        timeline->addTrack(std::make_shared<Track>("t", std::make_shared<PSeries>(0, 1), nullptr,
+                                                   std::make_shared<PSequence>(std::vector<double>{0.25})));
+        timeline->attachOutput([&events](const Event &) { events.fetch_add(1, std::memory_order_relaxed); });
+        timelines.push_back(timeline);
+        scheduler.add(timeline);
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    scheduler.stop();
+
+    report.add("scheduler", "timelines_one_thread",
+               {{"timelines", static_cast<double>(numTimelines)},
+                {"ticks_per_sec", static_cast<double>(scheduler.getTotalTicks()) / seconds},
+                {"events_per_sec", static_cast<double>(events.load()) / seconds},
+                {"late_ticks", static_cast<double>(scheduler.getLateTicks())}});
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "bench.h"
+#include "../Key.h"
+#include "../Scale.h"
+#include "../Chord.h"
+#include "../KeyDetector.h"
+
+// Key, Scale and Chord queries over a spread of arguments.
+inline void benchTheory(BenchReport &report)
+{
+    Key key(2, Scale::byName("minor"));
+    Key other(7, Scale::byName("major"));
+    Scale *scale = Scale::byName("major");
+    isobar::Chord chord({4, 3, 4}, 0, "bench chord");
+
+    int i = 0;
+    report.measure("theory", "Key::get", [&]() { keep(key.get(i++ & 31)); });
+    report.measure("theory", "Key::contains", [&]() { keep(key.contains(i++ & 127)); });
+    report.measure("theory", "Key::nearestNote", [&]() { keep(key.nearestNote(i++ & 127)); });
+    report.measure("theory", "Key::voiceleading", [&]() { keep(key.voiceleading(other)); });
+    report.measure("theory", "Scale::get", [&]() { keep(scale->get(i++ & 31)); });
+    report.measure("theory", "Scale::randomNote", [&]() { keep(scale->randomNote()); });
+    report.measure("theory", "Chord::getSemitones", [&]() { keep(chord.getSemitones()); });
+
+    // One note in, one estimate out, over a 64-note window.
+    KeyDetector detector(64);
+    report.measure("theory", "KeyDetector::add+estimate", [&]()
+    {
+        int n = i++;
+        detector.add(48 + (n * 7) % 36, 1 + (n & 3));
+        keep(detector.estimate().correlation);
+    });
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "bench.h"
+#include "../Sequence.h"
+#include "../Timeline.h"
+#include "../ThreadPool.h"
+
+// Offline render of many generative tracks, repeated for 1..N threads.
+inline void benchParallelTracks(BenchReport &report, int numTracks = 512, Tick numTicks = 48000)
+{
+    double baseline = 0.0;
+    for (unsigned threads : threadCounts())
+    {
+        Timeline timeline(120, 480);
+        if (threads > 1)
+        {
+            timeline.setThreadPool(std::make_shared<ThreadPool>(threads - 1));
+        }
+        for (int i = 0; i < numTracks; ++i)
+        {
+            auto notes = std::make_shared<PLoop>(std::make_shared<PSeries>(48 + i % 24, 1, 16));
+            auto durations = std::make_shared<PSequence>(std::vector<double>{0.125, 0.25, 0.125, 0.5});
+            timeline.addTrack(std::make_shared<Track>("track" + std::to_string(i), notes, nullptr, durations));
+        }
+
+        std::vector<Event> events;
+        events.reserve(static_cast<size_t>(numTracks) * numTicks / 100);
+        auto begin = std::chrono::steady_clock::now();
+        for (Tick t = 0; t < numTicks; t += 480)
+        {
+            timeline.render(480, events);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if (threads == 1) baseline = seconds;
+
+        report.add("timeline", "parallel_tracks/threads=" + std::to_string(threads),
+                   {{"tracks", static_cast<double>(numTracks)},
+                    {"seconds", seconds},
+                    {"events_per_sec", events.size() / seconds},
+                    {"speedup", baseline / seconds}});
+    }
+}
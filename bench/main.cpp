@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "bench_patterns.h"
+#include "bench_dict.h"
+#include "bench_markov.h"
+#include "bench_rhythm.h"
+#include "bench_generator.h"
+#include "bench_cache.h"
+#include "bench_theory.h"
+#include "bench_clock.h"
+#include "bench_timeline.h"
+#include "bench_scheduler.h"
+#include "bench_midi.h"
+#include "bench_osc.h"
+
+static const char *usage = "Usage: bench [--format json|csv] [--output file] [suite...]";
+
+// With no suites named, every suite runs. Results go to stdout by default.
+int main(int argc, char **argv)
+{
+    std::string format = "json";
+    std::string output;
+    std::vector<std::string> only;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!std::strcmp(argv[i], "--format") && i + 1 < argc)
+            format = argv[++i];
+        else if (!std::strcmp(argv[i], "--output") && i + 1 < argc)
+            output = argv[++i];
+        else
+            only.push_back(argv[i]);
+    }
+    if (format != "json" && format != "csv")
+    {
+        std::cerr << "Unknown format: " << format << std::endl;
+        return 1;
+    }
+
+    const std::vector<std::pair<std::string, std::function<void(BenchReport &)>>> suites = {
+        {"patterns", [](BenchReport &r) { benchPatterns(r); }},
+        {"dict", [](BenchReport &r) { benchDict(r); }},
+        {"markov", [](BenchReport &r) { benchMarkov(r); }},
+        {"rhythm", [](BenchReport &r) { benchRhythm(r); }},
+        {"generator", [](BenchReport &r) { benchGenerator(r); }},
+        {"cache", [](BenchReport &r) { benchCache(r); }},
+        {"theory", [](BenchReport &r) { benchTheory(r); }},
+        {"clock", [](BenchReport &r) { benchClockJitter(r); }},
+        {"timeline", [](BenchReport &r) { benchParallelTracks(r); }},
+        {"scheduler", [](BenchReport &r) { benchScheduler(r); }},
+        {"midi", [](BenchReport &r) { benchMidiWriter(r); }},
+        {"osc", [](BenchReport &r) { benchOscLoopback(r); }},
+    };
+
+    for (const std::string &name : only)
+    {
+        auto known = [&name](const auto &suite) { return suite.first == name; };
+        if (std::none_of(suites.begin(), suites.end(), known))
+        {
+            std::cerr << "Unknown suite: " << name << "\n" << usage << "\nSuites:";
+            for (const auto &suite : suites) std::cerr << " " << suite.first;
+            std::cerr << std::endl;
+            return 1;
+        }
+    }
+
+    BenchReport report;
+    for (const auto &suite : suites)
+    {
+        if (!only.empty() && std::find(only.begin(), only.end(), suite.first) == only.end()) continue;
+        std::cerr << "running " << suite.first << std::endl;
+        suite.second(report);
+    }
+
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output);
+        if (!file)
+        {
+            std::cerr << "Could not open " << output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = output.empty() ? std::cout : file;
+    out.precision(10);
+    if (format == "csv")
+        report.writeCsv(out);
+    else
+        report.writeJson(out);
+    return 0;
+}
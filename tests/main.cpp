@@ -2,6 +2,25 @@
 #include "doctest.h"
 #include "test_keys.h"
 #include "test_chord.h"
+#include "test_sequence.h"
+#include "test_timeline.h"
+#include "test_lookahead.h"
+#include "test_scheduler.h"
+#include "test_process.h"
+#include "test_midi.h"
+#include "test_osc.h"
+#include "test_trace.h"
+#include "test_stats.h"
+#include "test_profile.h"
+#include "test_dict.h"
+#include "test_operators.h"
+#include "test_markov.h"
+#include "test_rhythm.h"
+#include "test_generator.h"
+#include "test_state.h"
+#include "test_cache.h"
+#include "test_voice.h"
+#include "test_keydetector.h"
 
 TEST_CASE("Example test case") {
     CHECK(1 + 1 == 2);
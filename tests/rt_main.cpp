@@ -0,0 +1,7 @@
+// Real-time safety tests. Built as their own target with ISOBAR_RT_CHECK=1,
+// because they replace the global allocation functions.
+#define ISOBAR_RT_CHECK_IMPLEMENT
+#include "../RtCheck.h"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "test_rt.h"
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "../Cache.h"
+#include "../Generator.h"
+#include "../Operators.h"
+#include "../Sequence.h"
+
+#include "doctest.h"
+
+static std::shared_ptr<Pattern> cachedRiff(double transpose)
+{
+    auto riff = std::make_shared<PLoop>(std::make_shared<PSequence>(std::vector<double>{0, 3, 5, 7, 10}, 1), 4);
+    return riff + transpose;
+}
+
+TEST_CASE("Identical subgraphs share one node and its rendered blocks")
+{
+    BlockCache cache(64, 8);
+    auto a = cache.intern(cachedRiff(60));
+    auto b = cache.intern(cachedRiff(60));
+    auto c = cache.intern(cachedRiff(48));
+    CHECK(cache.stats().nodes == 2);
+
+    auto reference = cachedRiff(60);
+    std::vector<double> expected(20), fromA(20), fromB(20);
+    CHECK(reference->nextBlock(expected.data(), 20) == 20);
+    CHECK(a->nextBlock(fromA.data(), 20) == 20);
+    for (double &value : fromB) value = b->next();
+    CHECK(fromA == expected);
+    CHECK(fromB == expected);
+    CHECK_THROWS_AS(a->next(), std::out_of_range);
+    CHECK(c->next() == 48);
+
+    BlockCacheStats stats = cache.stats();
+    CHECK(stats.misses == 4);
+    CHECK(stats.hits == 3);
+
+    auto generated = std::make_shared<PGenerator>([]() -> Generator<double> { co_yield 1; });
+    CHECK(cache.intern(generated) == generated);
+}
+
+TEST_CASE("Cursors stay correct after their blocks are evicted")
+{
+    BlockCache cache(2, 4);
+    auto lead = cache.intern(std::make_shared<PSeries>(0, 1));
+    auto trail = cache.intern(std::make_shared<PSeries>(0, 1));
+    double block[32];
+    CHECK(lead->nextBlock(block, 32) == 32);
+    CHECK(block[31] == 31);
+    CHECK(trail->next() == 0);
+    CHECK(trail->next() == 1);
+    CHECK(cache.stats().evictions > 0);
+    CHECK(cache.stats().blocks == 2);
+
+    Snapshot snapshot = saveState(*lead);
+    CHECK(lead->next() == 32);
+    loadState(*lead, snapshot);
+    CHECK(lead->next() == 32);
+    lead->reset();
+    CHECK(lead->next() == 0);
+}
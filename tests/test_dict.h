@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "../Dict.h"
+#include "../Sequence.h"
+
+#include "doctest.h"
+
+TEST_CASE("Pattern::nextBlock matches next()")
+{
+    PSequence blockSeq(std::vector<double>{1, 2, 3}, 3);
+    PSequence stepSeq(std::vector<double>{1, 2, 3}, 3);
+    std::vector<double> block(4);
+    std::vector<double> expected;
+    for (int i = 0; i < 9; ++i) expected.push_back(stepSeq.next());
+
+    std::vector<double> actual;
+    size_t n;
+    while ((n = blockSeq.nextBlock(block.data(), block.size())) > 0)
+    {
+        actual.insert(actual.end(), block.begin(), block.begin() + n);
+    }
+    CHECK((actual == expected));
+
+    PSeries series(10, 2, 5);
+    CHECK(series.nextBlock(block.data(), 4) == 4);
+    CHECK(block[3] == 16);
+    CHECK(series.nextBlock(block.data(), 4) == 1);
+    CHECK(block[0] == 18);
+
+    // Default implementation, through PLoop.
+    PLoop loop(std::make_shared<PSeries>(0, 1, 2), 2);
+    CHECK(loop.nextBlock(block.data(), 4) == 4);
+    CHECK((block == std::vector<double>{0, 1, 0, 1}));
+}
+
+TEST_CASE("PDict fills note columns and stops with the shortest field")
+{
+    PDict dict(std::make_shared<PSequence>(std::vector<double>{60, 62, 64}, 2),
+               std::make_shared<PSeries>(100, -10),
+               0.5,
+               3.0);
+
+    NoteBlock block;
+    CHECK(dict.nextBlock(block, 4) == 4);
+    CHECK((block.pitch == std::vector<int>{60, 62, 64, 60}));
+    CHECK((block.velocity == std::vector<int>{100, 90, 80, 70}));
+    CHECK((block.duration == std::vector<double>{0.5, 0.5, 0.5, 0.5}));
+    CHECK((block.channel == std::vector<int>{3, 3, 3, 3}));
+
+    CHECK(dict.nextBlock(block, 4) == 2);
+    CHECK(block.size() == 2);
+    CHECK((block.pitch == std::vector<int>{62, 64}));
+    CHECK(dict.nextBlock(block, 4) == 0);
+
+    dict.reset();
+    CHECK(dict.nextBlock(block, 1) == 1);
+    CHECK(block.pitch[0] == 60);
+    CHECK(block.velocity[0] == 100);
+}
+
+TEST_CASE("PDict keeps values drawn past the shortest field")
+{
+    auto velocities = std::make_shared<PSequence>(std::vector<double>{100, 90, 80}, 1);
+    PDict dict(std::make_shared<PSeries>(60, 1), velocities);
+
+    NoteBlock block;
+    CHECK(dict.nextBlock(block, 4) == 3);
+    CHECK((block.pitch == std::vector<int>{60, 61, 62}));
+
+    // The pitch drawn for the fourth event comes out first once velocities
+    // are available again.
+    velocities->reset();
+    CHECK(dict.nextBlock(block, 4) == 3);
+    CHECK((block.pitch == std::vector<int>{63, 64, 65}));
+    CHECK((block.velocity == std::vector<int>{100, 90, 80}));
+}
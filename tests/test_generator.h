@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "../Generator.h"
+#include "../Sequence.h"
+#include "../Timeline.h"
+
+#include "doctest.h"
+
+TEST_CASE("PGenerator yields coroutine values and restarts on reset")
+{
+    PGenerator fib([]() -> Generator<double>
+    {
+        double a = 0, b = 1;
+        while (true)
+        {
+            co_yield a;
+            b = a + std::exchange(a, b);
+        }
+    });
+    std::vector<double> values;
+    for (int i = 0; i < 7; ++i) values.push_back(fib.next());
+    CHECK((values == std::vector<double>{0, 1, 1, 2, 3, 5, 8}));
+
+    fib.reset();
+    CHECK(fib.next() == 0);
+    CHECK(fib.next() == 1);
+}
+
+TEST_CASE("PGenerator ends like other patterns")
+{
+    auto arpeggio = std::make_shared<PGenerator>([]() -> Generator<double>
+    {
+        for (int note : {60, 64, 67}) co_yield note;
+    });
+    PLoop loop(arpeggio, 2);
+    std::vector<double> values;
+    try
+    {
+        while (true) values.push_back(loop.next());
+    }
+    catch (const std::out_of_range &)
+    {
+    }
+    CHECK((values == std::vector<double>{60, 64, 67, 60, 64, 67}));
+
+    // Patterns read inside the body end the generator when they run out.
+    auto series = std::make_shared<PSeries>(0, 2, 3);
+    PGenerator doubled([series]() -> Generator<double>
+    {
+        while (true) co_yield series->next() * 2;
+    });
+    double out[8];
+    CHECK(doubled.nextBlock(out, 8) == 3);
+    CHECK(out[2] == 8);
+    CHECK_THROWS_AS(doubled.next(), std::out_of_range);
+}
+
+TEST_CASE("Generators reuse pooled frames")
+{
+    Generator<Event> events = []() -> Generator<Event>
+    {
+        for (int i = 0; i < 2; ++i) co_yield Event{i * 480, 0, 0, 60 + i, 100, 240};
+    }();
+    Event event{};
+    CHECK(events.next(event));
+    CHECK(events.next(event));
+    CHECK(event.tick == 480);
+    CHECK(event.note == 61);
+    CHECK_FALSE(events.next(event));
+
+    PGenerator counter([]() -> Generator<double>
+    {
+        for (double i = 0;; ++i) co_yield i;
+    });
+    size_t chunks = FramePool::instance().getChunks();
+    for (int i = 0; i < 1000; ++i)
+    {
+        counter.reset();
+        counter.next();
+    }
+    CHECK(FramePool::instance().getChunks() == chunks);
+}
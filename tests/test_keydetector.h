@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../KeyDetector.h"
+#include "../MidiWriter.h"
+#include "../ThreadPool.h"
+
+#include "doctest.h"
+
+static std::vector<Scale *> majorAndMinor()
+{
+    return {Scale::byName("major"), Scale::byName("minor")};
+}
+
+TEST_CASE("Key detector finds major and minor keys")
+{
+    KeyDetector detector(32, majorAndMinor());
+    CHECK(detector.numCandidates() == 24);
+    for (int note : {60, 62, 64, 65, 67, 69, 71, 72, 67, 64, 60}) detector.add(note);
+    CHECK(detector.estimate().key == Key(0, Scale::byName("major")));
+    CHECK(detector.estimate().correlation > 0.7);
+
+    detector.reset();
+    for (int note : {57, 60, 64, 69, 68, 69, 71, 72, 64, 57}) detector.add(note);
+    CHECK(detector.estimate().key == Key(9, Scale::byName("minor")));
+}
+
+TEST_CASE("Sliding window follows a modulation and matches a fresh count")
+{
+    std::vector<int> notes;
+    for (int i = 0; i < 40; ++i) notes.push_back(std::vector<int>{60, 64, 67, 65, 62, 71, 69, 72}[i % 8]);
+    for (int i = 0; i < 40; ++i) notes.push_back(std::vector<int>{67, 71, 74, 72, 69, 66, 64, 79}[i % 8]);
+
+    KeyDetector sliding(16, majorAndMinor());
+    for (size_t i = 0; i < 40; ++i) sliding.add(notes[i], 1 + i % 3);
+    CHECK(sliding.estimate().key == Key(0, Scale::byName("major")));
+    for (size_t i = 40; i < notes.size(); ++i) sliding.add(notes[i], 1 + i % 3);
+    CHECK(sliding.estimate().key == Key(7, Scale::byName("major")));
+    CHECK(sliding.size() == 16);
+
+    KeyDetector fresh(16, majorAndMinor());
+    for (size_t i = notes.size() - 16; i < notes.size(); ++i) fresh.add(notes[i], 1 + i % 3);
+    auto a = sliding.scores(), b = fresh.scores();
+    for (size_t c = 0; c < a.size(); ++c) CHECK(std::abs(a[c].correlation - b[c].correlation) < 1e-9);
+}
+
+TEST_CASE("Batch key detection over MIDI files")
+{
+    std::vector<std::string> paths = {"test_key_d.mid", "test_key_e.mid"};
+    std::vector<std::vector<int>> melodies = {{62, 66, 69, 67, 64, 61, 62, 74}, {64, 67, 71, 66, 72, 71, 63, 64}};
+    for (size_t f = 0; f < paths.size(); ++f)
+    {
+        MidiWriter writer(paths[f], TimeBase(120, 96), 0, 256);
+        for (size_t i = 0; i < melodies[f].size(); ++i)
+        {
+            writer.write(Event{static_cast<Tick>(i) * 96, 0, 0, melodies[f][i], 100, 96});
+        }
+        writer.close();
+    }
+
+    std::vector<std::shared_ptr<const MidiFile>> files;
+    for (const auto &path : paths) files.push_back(MidiFile::open(path));
+    ThreadPool pool(2);
+    auto keys = KeyDetector::detect(files, &pool, majorAndMinor());
+    CHECK(keys[0].key == Key(2, Scale::byName("major")));
+    CHECK(keys[1].key == Key(4, Scale::byName("minor")));
+    for (const auto &path : paths) std::remove(path.c_str());
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../Sequence.h"
+#include "../Lookahead.h"
+#include "../RingBuffer.h"
+
+#include "doctest.h"
+
+TEST_CASE("RingBuffer is FIFO and bounded")
+{
+    RingBuffer<int> ring(3);
+    CHECK(ring.capacity() == 4);
+    for (int i = 0; i < 4; ++i)
+    {
+        CHECK(ring.push(i));
+    }
+    CHECK(!ring.push(4));
+    CHECK(ring.size() == 4);
+
+    int value = -1;
+    CHECK(ring.pop(value));
+    CHECK(value == 0);
+    CHECK(ring.push(4));
+    for (int expected = 1; expected <= 4; ++expected)
+    {
+        CHECK(ring.pop(value));
+        CHECK(value == expected);
+    }
+    CHECK(!ring.pop(value));
+}
+
+TEST_CASE("LookaheadPipeline dispatches rendered events in order")
+{
+    auto timeline = std::make_shared<Timeline>(6000, 4);
+    timeline->addTrack(std::make_shared<Track>("a", std::make_shared<PSeries>(0, 1), nullptr,
+                                               std::make_shared<PSequence>(std::vector<double>{0.25})));
+
+    std::vector<Event> received;
+    LookaheadPipeline pipeline(timeline, 32, 64);
+    pipeline.attachOutput([&](const Event &event) { received.push_back(event); });
+    pipeline.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    pipeline.edit([](Timeline &t) {
+        t.addTrack(std::make_shared<Track>("b", std::make_shared<PSeries>(100, 1)));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    pipeline.stop();
+
+    REQUIRE(!received.empty());
+    const Event *firstEdited = nullptr;
+    Tick lastTick = -1;
+    int lastNote = -1;
+    for (const auto &event : received)
+    {
+        CHECK(event.tick < pipeline.getPlayhead());
+        CHECK(event.tick >= lastTick);
+        lastTick = event.tick;
+        if (event.track == 0)
+        {
+            // Rewinding for the edit neither repeats nor skips a note.
+            CHECK(event.note == lastNote + 1);
+            lastNote = event.note;
+        }
+        if (event.track == 1 && !firstEdited) firstEdited = &event;
+    }
+    // The added track starts at the playhead rather than catching up from 0.
+    REQUIRE(firstEdited);
+    CHECK(firstEdited->note == 100);
+    CHECK(firstEdited->tick > 0);
+
+    auto stats = pipeline.stats();
+    CHECK(stats.capacity == 64);
+    CHECK(stats.rerenders == 1);
+    CHECK(stats.highWater <= stats.capacity);
+}
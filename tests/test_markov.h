@@ -0,0 +1,117 @@
+#pragma once
+
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "../Markov.h"
+#include "../ThreadPool.h"
+
+#include "doctest.h"
+
+TEST_CASE("Markov model counts transitions per context")
+{
+    std::vector<std::vector<double>> corpus = {{60, 62, 60, 64, 60, 62}, {60, 62}};
+    auto model = MarkovModel::train(corpus, 1);
+    std::vector<double> c60 = {60}, c62 = {62}, c64 = {64};
+
+    CHECK(model->getAlphabet().size() == 3);
+    CHECK(model->numStates() == 3);
+    CHECK(model->numTransitions() == 4);
+    CHECK(model->count(c60, 62) == 3);
+    CHECK(model->count(c60, 64) == 1);
+    CHECK(model->count(c62, 60) == 1);
+    CHECK(model->count(c64, 60) == 1);
+    CHECK(model->count(c62, 64) == 0);
+
+    auto second = MarkovModel::train(corpus, 2);
+    std::vector<double> c6062 = {60, 62};
+    CHECK(second->count(c6062, 60) == 1);
+    CHECK(second->count(c60, 62) == 0);
+}
+
+TEST_CASE("Parallel sharded training matches serial training")
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> note(48, 72);
+    std::vector<std::vector<double>> corpus(5);
+    for (auto &sequence : corpus)
+    {
+        for (int i = 0; i < 2000; ++i) sequence.push_back(note(rng));
+    }
+
+    ThreadPool pool(3);
+    auto serial = MarkovModel::train(corpus, 2);
+    auto parallel = MarkovModel::train(corpus, 2, &pool, 37);
+    CHECK(serial->numStates() == parallel->numStates());
+    CHECK(serial->numTransitions() == parallel->numTransitions());
+
+    std::uint64_t total = 0;
+    for (double a : serial->getAlphabet())
+    {
+        for (double b : serial->getAlphabet())
+        {
+            std::vector<double> context = {a, b};
+            for (double c : serial->getAlphabet())
+            {
+                std::uint64_t n = serial->count(context, c);
+                CHECK(parallel->count(context, c) == n);
+                total += n;
+            }
+        }
+    }
+    CHECK(total == 5 * (2000 - 2));
+}
+
+TEST_CASE("PMarkov samples in proportion to counts and is reproducible")
+{
+    // After 1: 2 three times out of four, 3 once; 2 and 3 always return to 1.
+    std::vector<std::vector<double>> corpus = {{1, 2, 1, 2, 1, 2, 1, 3, 1}};
+    auto model = MarkovModel::train(corpus, 1);
+
+    PMarkov markov(model, 42);
+    int twos = 0, threes = 0;
+    double previous = markov.next();
+    for (int i = 0; i < 40000; ++i)
+    {
+        double value = markov.next();
+        if (previous == 1)
+        {
+            if (value == 2) twos++;
+            if (value == 3) threes++;
+        }
+        else
+        {
+            CHECK(value == 1);
+        }
+        previous = value;
+    }
+    CHECK(static_cast<double>(twos) / (twos + threes) > 0.73);
+    CHECK(static_cast<double>(twos) / (twos + threes) < 0.77);
+
+    std::vector<double> first, second;
+    markov.reset();
+    for (int i = 0; i < 16; ++i) first.push_back(markov.next());
+    markov.reset();
+    for (int i = 0; i < 16; ++i) second.push_back(markov.next());
+    CHECK((first == second));
+}
+
+TEST_CASE("An order-7 model takes all 256 MIDI notes")
+{
+    std::vector<std::vector<double>> corpus(1);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int note = 0; note < 256; ++note) corpus[0].push_back(note);
+    }
+    auto model = MarkovModel::train(corpus, 7);
+    CHECK(model->getAlphabet().size() == 256);
+    CHECK(model->numStates() == 256);
+    std::vector<double> context = {248, 249, 250, 251, 252, 253, 254};
+    CHECK(model->count(context, 255) == 2);
+    std::vector<double> wrapped = {252, 253, 254, 255, 0, 1, 2};
+    CHECK(model->count(wrapped, 3) == 1);
+
+    corpus[0].push_back(256);
+    CHECK_THROWS_AS(MarkovModel::train(corpus, 7), std::invalid_argument);
+}
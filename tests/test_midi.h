@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "../Sequence.h"
+#include "../MidiWriter.h"
+#include "../MidiReader.h"
+
+#include "doctest.h"
+
+static std::vector<unsigned char> readBytes(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("MidiWriter writes a type 0 file with VLQ deltas and note-offs")
+{
+    const std::string path = "test_writer.mid";
+    {
+        MidiWriter writer(path, TimeBase(120, 96), 0, 64);
+        writer.write(Event{0, 0, 0, 60, 100, 96});
+        writer.write(Event{200, 0, 1, 62, 80, 96});
+        writer.close();
+        CHECK(writer.eventsWritten() == 2);
+    }
+
+    auto bytes = readBytes(path);
+    std::vector<unsigned char> expected = {
+        'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96,
+        'M', 'T', 'r', 'k', 0, 0, 0, 25,
+        0x00, 0xff, 0x51, 0x03, 0x07, 0xa1, 0x20, // tempo 500000
+        0x00, 0x90, 60, 100,                      // note-on
+        0x60, 60, 0,                              // note-off at 96, running status
+        0x68, 0x91, 62, 80,                       // 104 ticks later, channel 2
+        0x60, 62, 0,
+        0x00, 0xff, 0x2f, 0x00};
+    CHECK(bytes == expected);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("MidiWriter streams a timeline render and tracks into type 1")
+{
+    const std::string path = "test_writer1.mid";
+    TimeBase base(120, 480);
+    {
+        MidiWriter writer(path, base, 1, 256);
+        Track a("a", std::make_shared<PSeries>(40, 1, 300), nullptr, std::make_shared<PSequence>(std::vector<double>{0.25}));
+        Track b("b", std::make_shared<PSeries>(60, 0, 100));
+        writeTrack(a, base, 480 * 1000, writer);
+        writeTrack(b, base, 480 * 1000, writer);
+        CHECK(writer.eventsWritten() == 400);
+        CHECK_THROWS_AS(writer.write(Event{0, 0, 0, 60, 100, 1}), std::logic_error);
+    }
+
+    auto bytes = readBytes(path);
+    REQUIRE(bytes.size() > 22);
+    CHECK(bytes[9] == 1);  // format
+    CHECK(bytes[11] == 2); // tracks
+    size_t firstLength = (bytes[18] << 24) | (bytes[19] << 16) | (bytes[20] << 8) | bytes[21];
+    size_t second = 22 + firstLength;
+    REQUIRE(bytes.size() > second + 8);
+    CHECK(bytes[second] == 'M');
+    CHECK(bytes[second + 3] == 'k');
+    std::remove(path.c_str());
+}
+
+TEST_CASE("MidiWriter bridges gaps longer than a delta-time and rejects slow tempos")
+{
+    const std::string path = "test_writer_gap.mid";
+    const Tick gap = 3 * 0x0fffffffLL + 5;
+    std::vector<Event> written = {{0, 0, 0, 60, 100, 10}, {gap, 0, 0, 62, 90, 10}, {gap + 20, 0, 0, 64, 80, 10}};
+    {
+        MidiWriter writer(path, TimeBase(120, 96));
+        writer.write(written);
+    }
+
+    auto file = MidiFile::open(path);
+    std::vector<MidiNote> notes(4);
+    auto reader = file->track(0);
+    REQUIRE(reader.read(notes.data(), notes.size()) == written.size());
+    for (size_t i = 0; i < written.size(); ++i)
+    {
+        CHECK(notes[i].tick == written[i].tick);
+        CHECK(notes[i].duration == 10);
+        CHECK(notes[i].note == written[i].note);
+    }
+    std::remove(path.c_str());
+
+    CHECK_THROWS_AS(MidiWriter(path, TimeBase(3, 96)), std::invalid_argument);
+}
+
+TEST_CASE("MidiFile reads back written notes as patterns")
+{
+    const std::string path = "test_reader.mid";
+    TimeBase base(100, 96);
+    std::vector<Event> written = {
+        {0, 0, 0, 60, 100, 48}, {0, 0, 1, 64, 90, 96}, {48, 0, 0, 67, 80, 24}, {300, 0, 0, 72, 70, 200}};
+    {
+        MidiWriter writer(path, base);
+        writer.write(written);
+    }
+
+    auto file = MidiFile::open(path);
+    CHECK(file->getFormat() == 0);
+    CHECK(file->getTicksPerBeat() == 96);
+    REQUIRE(file->numTracks() == 1);
+
+    std::vector<MidiNote> notes(8);
+    auto reader = file->track(0);
+    REQUIRE(reader.read(notes.data(), notes.size()) == written.size());
+    for (size_t i = 0; i < written.size(); ++i)
+    {
+        CHECK(notes[i].tick == written[i].tick);
+        CHECK(notes[i].duration == written[i].duration);
+        CHECK(notes[i].channel == written[i].channel);
+        CHECK(notes[i].note == written[i].note);
+        CHECK(notes[i].velocity == written[i].velocity);
+    }
+
+    PMidiNotes pitches(file, 0, PMidiNotes::Field::Pitch);
+    PMidiNotes durations(file, 0, PMidiNotes::Field::Duration);
+    CHECK(pitches.next() == 60);
+    CHECK(durations.next() == 0.5);
+    CHECK(durations.next() == 1.0);
+    for (int i = 0; i < 3; ++i) pitches.next();
+    CHECK_THROWS_AS(pitches.next(), std::out_of_range);
+    pitches.reset();
+    CHECK(pitches.next() == 60);
+
+    // A snapshot taken between notes carries the notes awaiting their note-off.
+    PMidiNotes fork(file, 0, PMidiNotes::Field::Pitch);
+    Snapshot afterFirst = saveState(pitches);
+    loadState(fork, afterFirst);
+    CHECK(fork.next() == 64);
+    CHECK(fork.next() == 67);
+    CHECK(pitches.next() == 64);
+
+    // Onset to onset; the last note runs to the end of the track.
+    PMidiNotes deltas(file, 0, PMidiNotes::Field::Delta);
+    CHECK(deltas.next() == 0.0);
+    CHECK(deltas.next() == 0.5);
+    CHECK(deltas.next() == 2.625);
+    CHECK(deltas.next() == 200.0 / 96);
+
+    CHECK_THROWS_AS(MidiFile::open("does_not_exist.mid"), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("MidiTrackReader matches note-offs in one pass and resets running status")
+{
+    // Two overlapping C4s closed by one note-off, an E4 held to the end of the
+    // track and a G4 ended by a running-status note-on with velocity 0.
+    const std::uint8_t track[] = {0x00, 0x90, 60, 100, 0x05, 60, 90, 0x00, 64, 80,
+                                  0x05, 0x80, 60, 0x00, 0x00, 0x90, 67, 70, 0x04, 67, 0,
+                                  0x03, 0xff, 0x2f, 0x00};
+    MidiTrackReader reader(track, track + sizeof(track));
+    MidiNote note;
+    REQUIRE(reader.next(note));
+    CHECK((note.tick == 0 && note.note == 60 && note.duration == 10));
+    REQUIRE(reader.next(note));
+    CHECK((note.tick == 5 && note.note == 60 && note.velocity == 90 && note.duration == 5));
+    REQUIRE(reader.next(note));
+    CHECK((note.tick == 5 && note.note == 64 && note.duration == 12));
+    REQUIRE(reader.next(note));
+    CHECK((note.tick == 10 && note.note == 67 && note.duration == 4));
+    CHECK_FALSE(reader.next(note));
+
+    // A meta event in between cancels running status, so the bare data bytes
+    // after it are an error.
+    const std::uint8_t broken[] = {0x00, 0x90, 60, 100, 0x00, 0xff, 0x01, 0x00, 0x05, 60, 0};
+    MidiTrackReader after(broken, broken + sizeof(broken));
+    CHECK_THROWS_AS(after.next(note), std::runtime_error);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "../Operators.h"
+#include "../Sequence.h"
+
+#include "doctest.h"
+
+static std::vector<double> takeNext(Pattern &pattern, int count)
+{
+    std::vector<double> values;
+    for (int i = 0; i < count; ++i) values.push_back(pattern.next());
+    return values;
+}
+
+static std::vector<double> takeBlock(Pattern &pattern, int count)
+{
+    std::vector<double> values(count);
+    values.resize(pattern.nextBlock(values.data(), values.size()));
+    return values;
+}
+
+TEST_CASE("Constant arithmetic and clamps fold into one PAffine")
+{
+    auto series = std::make_shared<PSeries>(0, 1);
+    auto expr = std::make_shared<PClamp>(-(series * 2 + 1) + 10, 0, 6) * 0.5 + 60;
+
+    auto affine = std::dynamic_pointer_cast<PAffine>(expr);
+    REQUIRE(affine);
+    // 10 - (2x + 1) = 9, 7, 5, 3, 1, -1 -> clamped to 6, 6, 5, 3, 1, 0 -> halved, + 60
+    CHECK((takeNext(*expr, 6) == std::vector<double>{63, 63, 62.5, 61.5, 60.5, 60}));
+
+    expr->reset();
+    CHECK((takeBlock(*expr, 6) == std::vector<double>{63, 63, 62.5, 61.5, 60.5, 60}));
+}
+
+TEST_CASE("PScale maps ranges and pattern operators combine values")
+{
+    PScale scale(std::make_shared<PSequence>(std::vector<double>{0, 0.5, 1}), 0, 1, 48, 72);
+    CHECK((takeBlock(scale, 3) == std::vector<double>{48, 60, 72}));
+
+    auto a = std::make_shared<PSequence>(std::vector<double>{1, 2, 3}, 1);
+    auto b = std::make_shared<PSeries>(10, 10);
+    auto sum = a + b;
+    CHECK((takeBlock(*sum, 8) == std::vector<double>{11, 22, 33}));
+    sum->reset();
+    CHECK((takeNext(*sum, 3) == std::vector<double>{11, 22, 33}));
+    CHECK_THROWS_AS(sum->next(), std::out_of_range);
+
+    auto product = std::make_shared<PSeries>(1, 1) * std::make_shared<PSeries>(2, 0);
+    CHECK((takeBlock(*product, 3) == std::vector<double>{2, 4, 6}));
+}
+
+TEST_CASE("Binary operators apply affine operands in their own loop")
+{
+    auto series = std::make_shared<PSeries>(0, 1);
+    auto steps = std::make_shared<PSequence>(std::vector<double>{1, 2, 3, 4}, 1);
+    auto expr = std::make_shared<PClamp>(series * 2 + 1, 0, 6) + steps * 10;
+    // clamp(2x + 1, 0, 6) + 10y
+    CHECK((takeBlock(*expr, 8) == std::vector<double>{11, 23, 35, 46}));
+    expr->reset();
+    CHECK((takeNext(*expr, 4) == std::vector<double>{11, 23, 35, 46}));
+
+    // The absorbed maps are part of the signature.
+    StateWriter scaled, plain;
+    REQUIRE((std::make_shared<PSeries>(0, 1) * 2 + std::make_shared<PSeries>(0, 1))->signature(scaled));
+    REQUIRE((std::make_shared<PSeries>(0, 1) + std::make_shared<PSeries>(0, 1))->signature(plain));
+    CHECK(scaled.data() != plain.data());
+}
+
+TEST_CASE("PDegree maps degrees through a key")
+{
+    Key key(2, Scale::byName("major"));
+    PDegree degrees(std::make_shared<PSequence>(std::vector<double>{0, 2, 4, 7, -1}), key);
+    CHECK((takeBlock(degrees, 5) == std::vector<double>{2, 6, 9, 14, -1}));
+    degrees.reset();
+    CHECK(degrees.next() == 2);
+}
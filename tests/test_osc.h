@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "../Sequence.h"
+#include "../Osc.h"
+
+#include "doctest.h"
+
+TEST_CASE("OSC time tags round-trip")
+{
+    auto now = std::chrono::system_clock::now();
+    auto back = osc::fromTimeTag(osc::timeTag(now));
+    CHECK(std::chrono::abs(back - now) < std::chrono::microseconds(1));
+}
+
+TEST_CASE("OscOutput bundles timeline events to a loopback receiver")
+{
+    OscReceiver receiver;
+    OscOutput output("127.0.0.1", receiver.getPort());
+
+    Timeline timeline(120, 4);
+    for (int i = 0; i < 3; ++i)
+    {
+        timeline.addTrack(std::make_shared<Track>("t" + std::to_string(i), std::make_shared<PSeries>(60 + i, 1), nullptr,
+                                                  std::make_shared<PSequence>(std::vector<double>{0.25})));
+    }
+    timeline.attachOutput([&output](const Event &event) { output.send(event); });
+    for (int tick = 0; tick < 20; ++tick)
+    {
+        timeline.tick();
+    }
+
+    auto notes = receiver.waitFor(60, std::chrono::seconds(2));
+    REQUIRE(notes.size() == 60);
+    for (size_t i = 0; i < notes.size(); ++i)
+    {
+        CHECK(notes[i].event.track == static_cast<int>(i % 3));
+        CHECK(notes[i].event.note == 60 + static_cast<int>(i % 3) + static_cast<int>(i / 3));
+        CHECK(notes[i].event.duration == 1);
+        CHECK(notes[i].latency.count() >= 0);
+    }
+    CHECK(output.getDropped() == 0);
+    // At most one bundle per tick, and sendmmsg batches several per call.
+    CHECK(output.getBundlesSent() <= 20);
+    CHECK(output.getSendCalls() <= output.getBundlesSent());
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "../Sequence.h"
+#include "../Timeline.h"
+
+#include "doctest.h"
+
+// Stands in for an audio host: calls Timeline::process once per buffer and
+// records each event at its absolute frame position.
+struct HostSimulator
+{
+    HostSimulator(double sampleRate, std::vector<int> blockSizes)
+        : sampleRate(sampleRate), blockSizes(blockSizes), frame(0) {}
+
+    std::vector<long long> run(Timeline &timeline, long long numFrames)
+    {
+        std::vector<long long> positions;
+        std::vector<BlockEvent> block;
+        size_t next = 0;
+        while (frame < numFrames)
+        {
+            int size = blockSizes[next++ % blockSizes.size()];
+            block.clear();
+            timeline.process(size, sampleRate, block);
+            for (const auto &e : block)
+            {
+                CHECK(e.offset >= 0);
+                CHECK(e.offset < size);
+                if (frame + e.offset < numFrames) positions.push_back(frame + e.offset);
+            }
+            frame += size;
+        }
+        return positions;
+    }
+
+    double sampleRate;
+    std::vector<int> blockSizes;
+    long long frame;
+};
+
+static std::shared_ptr<Timeline> makeProcessTimeline()
+{
+    // 100 BPM at 480 PPQ gives 0.91875 frames per tick at 44.1 kHz, so tick
+    // boundaries never line up with block boundaries.
+    auto timeline = std::make_shared<Timeline>(100, 480);
+    timeline->addTrack(std::make_shared<Track>("a", std::make_shared<PSeries>(60, 1), nullptr,
+                                               std::make_shared<PSequence>(std::vector<double>{0.25, 0.5, 1.0 / 3.0})));
+    return timeline;
+}
+
+TEST_CASE("Timeline process places events at sample-accurate offsets")
+{
+    auto timeline = makeProcessTimeline();
+    HostSimulator host(44100.0, {512});
+    auto positions = host.run(*timeline, 44100 * 4);
+
+    // The first events land on beats 0, 0.25 and 0.75: 0, 6615 and 19845 frames.
+    REQUIRE(positions.size() >= 3);
+    CHECK(positions[0] == 0);
+    CHECK(positions[1] == 6615);
+    CHECK(positions[2] == 19845);
+}
+
+TEST_CASE("Timeline process is independent of host block size")
+{
+    auto reference = HostSimulator(48000.0, {64}).run(*makeProcessTimeline(), 48000 * 8);
+    auto irregular = HostSimulator(48000.0, {1, 480, 97, 2048, 13}).run(*makeProcessTimeline(), 48000 * 8);
+    CHECK(reference.size() > 10);
+    CHECK(reference == irregular);
+}
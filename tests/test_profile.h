@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../Profile.h"
+#include "../Sequence.h"
+
+#include "doctest.h"
+
+TEST_CASE("PProfile builds a call tree with counters")
+{
+    Profiler::instance().clear();
+    auto seq = std::make_shared<PProfile>("seq", std::make_shared<PSequence>(std::vector<double>{1, 2, 3}, 1));
+    auto loop = std::make_shared<PProfile>("loop", std::make_shared<PLoop>(seq, 2));
+
+    std::vector<double> values;
+    try
+    {
+        while (true) values.push_back(loop->next());
+    }
+    catch (const std::out_of_range &)
+    {
+    }
+    CHECK((values == std::vector<double>{1, 2, 3, 1, 2, 3}));
+
+    const ProfileNode &outer = loop->stats();
+    const ProfileNode &inner = seq->stats();
+    CHECK(outer.calls == 7);
+    CHECK(outer.exhaustions == 1);
+    CHECK(inner.calls == 4);
+    CHECK(inner.exhaustions == 1);
+    CHECK(inner.parent == &outer);
+    CHECK(outer.childNanos == inner.totalNanos);
+    CHECK(outer.bufferBytes >= 3 * sizeof(double));
+    CHECK(outer.bufferGrowths >= 1);
+
+    loop->reset();
+    CHECK(outer.resets == 1);
+
+    std::ostringstream tree;
+    Profiler::instance().printTree(tree);
+    CHECK(tree.str().find("loop calls=7") == 0);
+    CHECK(tree.str().find("\n  seq calls=4") != std::string::npos);
+
+    std::ostringstream folded;
+    Profiler::instance().writeFolded(folded);
+    CHECK(folded.str().find("loop;seq ") != std::string::npos);
+    Profiler::instance().clear();
+}
+
+TEST_CASE("ISOBAR_PROFILE_PATTERN is a no-op unless profiling is compiled in")
+{
+    auto seq = std::make_shared<PSequence>(std::vector<double>{1});
+    std::shared_ptr<Pattern> wrapped = ISOBAR_PROFILE_PATTERN("seq", seq);
+    CHECK((wrapped == seq) == !ISOBAR_PROFILE);
+}
+
+TEST_CASE("PProfile forwards block reads and signatures")
+{
+    Profiler::instance().clear();
+    auto plain = std::make_shared<PSequence>(std::vector<double>{1, 2, 3}, 2);
+    PProfile seq("seq", std::make_shared<PSequence>(std::vector<double>{1, 2, 3}, 2));
+
+    double values[8];
+    CHECK(seq.nextBlock(values, 4) == 4);
+    CHECK(seq.nextBlock(values + 4, 4) == 2);
+    CHECK((std::vector<double>(values, values + 6) == std::vector<double>{1, 2, 3, 1, 2, 3}));
+    CHECK(seq.stats().calls == 2);
+    CHECK(seq.stats().exhaustions == 1);
+
+    StateWriter profiled, unwrapped;
+    CHECK(seq.signature(profiled));
+    CHECK(plain->signature(unwrapped));
+    CHECK((profiled.data() == unwrapped.data()));
+    Profiler::instance().clear();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include "../Rhythm.h"
+#include "../Sequence.h"
+
+#include "doctest.h"
+
+TEST_CASE("Euclidean, density and rotation masks")
+{
+    CHECK(RhythmMask::euclidean(3, 8).toString() == "x..x..x.");
+    CHECK(RhythmMask::euclidean(5, 8).toString() == "x.x.xx.x");
+    CHECK(RhythmMask::euclidean(0, 4).toString() == "....");
+    CHECK(RhythmMask::euclidean(3, 8, 3).toString() == "x..x.x..");
+    CHECK(RhythmMask::euclidean(3, 8).rotated(-1).toString() == ".x..x..x");
+    CHECK(RhythmMask::withDensity(16, 0.25).toString() == "x...x...x...x...");
+    CHECK(RhythmMask::euclidean(7, 100).count() == 7);
+    CHECK_THROWS_AS(RhythmMask::euclidean(9, 8), std::invalid_argument);
+
+    RhythmMask wide = RhythmMask::euclidean(4, 130);
+    CHECK(wide.rotated(130) == wide);
+    CHECK(wide.rotated(5).rotated(-5) == wide);
+    CHECK(wide.rotated(1).hit(129));
+}
+
+TEST_CASE("Boolean combinations use the common cycle")
+{
+    RhythmMask threes = RhythmMask::fromString("x..");
+    RhythmMask fours = RhythmMask::fromString("x...");
+    CHECK((threes | fours).toString() == "x..xx.x.xx..");
+    CHECK((threes & fours).toString() == "x...........");
+    CHECK((threes ^ fours).toString() == "...xx.x.xx..");
+    CHECK((~fours).toString() == ".xxx");
+    CHECK((~RhythmMask(64)).count() == 64);
+}
+
+TEST_CASE("Onset queries jump across words")
+{
+    RhythmMask mask(200);
+    mask.set(3);
+    mask.set(150);
+    CHECK(mask.nextOnset(0) == 3);
+    CHECK(mask.nextOnset(3) == 3);
+    CHECK(mask.nextOnset(4) == 150);
+    CHECK(mask.nextOnset(151) == 3);
+    CHECK(mask.stepsToOnset(151) == 52);
+    CHECK(RhythmMask(10).nextOnset(0) == -1);
+
+    PRhythm rhythm(mask);
+    CHECK(rhythm.skipToOnset() == 3);
+    CHECK(rhythm.next() == 1);
+    CHECK(rhythm.skipToOnset() == 146);
+    CHECK(rhythm.next() == 1);
+    CHECK(rhythm.stepsToOnset() == 52);
+}
+
+TEST_CASE("PRhythm::nextBlock matches next() and PImpulse")
+{
+    RhythmMask mask = RhythmMask::euclidean(5, 70, 2);
+    PRhythm stepped(mask), blocked(mask);
+    std::vector<double> expected, actual(333);
+    for (int i = 0; i < 333; ++i) expected.push_back(stepped.next());
+    CHECK(blocked.nextBlock(actual.data(), 100) == 100);
+    CHECK(blocked.nextBlock(actual.data() + 100, 233) == 233);
+    CHECK((actual == expected));
+
+    PImpulse impulse(5);
+    PRhythm pulse(RhythmMask::euclidean(1, 5));
+    for (int i = 0; i < 20; ++i) CHECK(impulse.next() == pulse.next());
+}
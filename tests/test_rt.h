@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../RtCheck.h"
+#include "../Key.h"
+#include "../Scheduler.h"
+#include "../Sequence.h"
+#include "../ThreadPool.h"
+#include "../Timeline.h"
+#include "../Voice.h"
+
+#include "doctest.h"
+
+static void ignoreViolation(const RtViolation &)
+{
+}
+
+TEST_CASE("Allocations and locks are reported only on real-time threads")
+{
+    RtCheck::setReporter(&ignoreViolation);
+    RtCheck::resetViolations();
+
+    CheckedMutex mutex;
+    {
+        auto values = std::make_unique<std::vector<int>>(16);
+        mutex.lock();
+        mutex.unlock();
+    }
+    CHECK(RtCheck::getViolations(RtViolationKind::Allocation) == 0);
+    CHECK(RtCheck::getViolations(RtViolationKind::Lock) == 0);
+
+    {
+        RtScope realtime;
+        auto values = std::make_unique<std::vector<int>>(16);
+        mutex.lock();
+        mutex.unlock();
+        CHECK(mutex.try_lock());
+        mutex.unlock();
+    }
+    CHECK(RtCheck::getViolations(RtViolationKind::Allocation) == 4); // two news, two deletes
+    CHECK(RtCheck::getViolations(RtViolationKind::Lock) == 1);
+
+    // Key::contains builds a sorted copy of the scale on every call.
+    RtCheck::resetViolations();
+    Key key(0);
+    {
+        RtScope realtime;
+        CHECK(key.contains(4));
+    }
+    CHECK(RtCheck::getViolations(RtViolationKind::Allocation) > 0);
+    RtCheck::setReporter(nullptr);
+}
+
+TEST_CASE("Reference timeline runs allocation- and lock-free on the clock thread")
+{
+    RtCheck::setReporter(&ignoreViolation);
+
+    Timeline timeline(600.0, 24);
+    for (int i = 0; i < 4; ++i)
+    {
+        timeline.addTrack(std::make_shared<Track>("t" + std::to_string(i),
+                                                  std::make_shared<PSequence>(std::vector<double>{60, 64, 67}),
+                                                  std::make_shared<PSequence>(std::vector<double>{100, 80}),
+                                                  std::make_shared<PSequence>(std::vector<double>{0.25, 0.125})));
+    }
+    std::atomic<int> events(0);
+    timeline.attachOutput([&events](const Event &) { events.fetch_add(1, std::memory_order_relaxed); });
+
+    // One tick in which every track plays sizes the evaluation buffers.
+    std::vector<Event> warmup;
+    timeline.render(1, warmup);
+
+    RtCheck::resetViolations();
+    timeline.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    timeline.stop();
+
+    CHECK(events.load() > 0);
+    CHECK(RtCheck::getViolations(RtViolationKind::Allocation) == 0);
+    CHECK(RtCheck::getViolations(RtViolationKind::Lock) == 0);
+    RtCheck::setReporter(nullptr);
+}
+
+TEST_CASE("Handing a tick to the thread pool is exempt from checking")
+{
+    RtCheck::setReporter(&ignoreViolation);
+
+    Timeline timeline(600.0, 24);
+    timeline.setThreadPool(std::make_shared<ThreadPool>(2));
+    for (int i = 0; i < 8; ++i)
+    {
+        timeline.addTrack(std::make_shared<Track>("t" + std::to_string(i),
+                                                  std::make_shared<PSequence>(std::vector<double>{60, 64, 67}),
+                                                  nullptr,
+                                                  std::make_shared<PSequence>(std::vector<double>{0.25})));
+    }
+    std::vector<Event> warmup;
+    timeline.render(1, warmup);
+
+    RtCheck::resetViolations();
+    {
+        RtScope realtime;
+        for (int i = 0; i < 48; ++i) timeline.tick();
+        CHECK(RtCheck::isRealtime());
+    }
+    CHECK(RtCheck::getViolations(RtViolationKind::Allocation) == 0);
+    CHECK(RtCheck::getViolations(RtViolationKind::Lock) == 0);
+    RtCheck::setReporter(nullptr);
+}
+
+TEST_CASE("Scheduled timelines tick allocation- and lock-free")
+{
+    RtCheck::setReporter(&ignoreViolation);
+
+    std::vector<std::shared_ptr<Timeline>> timelines;
+    std::atomic<int> events(0);
+    for (int i = 0; i < 3; ++i)
+    {
+        auto timeline = std::make_shared<Timeline>(600.0, 24);
+        timeline->addTrack(std::make_shared<Track>("t", std::make_shared<PSequence>(std::vector<double>{60, 64, 67}),
+                                                   std::make_shared<PSequence>(std::vector<double>{100, 80}),
+                                                   std::make_shared<PSequence>(std::vector<double>{0.25, 0.125})));
+        timeline->attachOutput([&events](const Event &) { events.fetch_add(1, std::memory_order_relaxed); });
+        std::vector<Event> warmup;
+        timeline->render(1, warmup);
+        timelines.push_back(timeline);
+    }
+
+    RtCheck::resetViolations();
+    {
+        Scheduler scheduler(2);
+        for (const auto &timeline : timelines) scheduler.add(timeline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CHECK(scheduler.getTotalTicks() > 0);
+    }
+
+    CHECK(events.load() > 0);
+    CHECK(RtCheck::getViolations(RtViolationKind::Allocation) == 0);
+    CHECK(RtCheck::getViolations(RtViolationKind::Lock) == 0);
+    RtCheck::setReporter(nullptr);
+}
+
+TEST_CASE("Voice allocation and stealing do not allocate")
+{
+    RtCheck::setReporter(&ignoreViolation);
+    VoiceAllocator voices(8, StealPolicy::Quietest);
+    int events = 0;
+    auto count = [&events](const VoiceEvent &) { events++; };
+
+    RtCheck::resetViolations();
+    {
+        RtScope realtime;
+        for (int i = 0; i < 1000; ++i)
+        {
+            voices.noteOn(i, i % 16, 36 + i % 48, 40 + i % 80, 24, count);
+            if (i % 3 == 0) voices.noteOff(i, i % 16, 36 + (i + 5) % 48, count);
+            voices.releaseUntil(i, count);
+        }
+        voices.releaseAll(1000, count);
+    }
+    CHECK(events >= 2000);
+    CHECK(voices.active() == 0);
+    CHECK(RtCheck::getViolations(RtViolationKind::Allocation) == 0);
+    CHECK(RtCheck::getViolations(RtViolationKind::Lock) == 0);
+    RtCheck::setReporter(nullptr);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../Sequence.h"
+#include "../Scheduler.h"
+
+#include "doctest.h"
+
+TEST_CASE("Scheduler ticks many timelines at their own rates")
+{
+    const int numTimelines = 200;
+    std::vector<std::shared_ptr<Timeline>> timelines;
+    std::vector<std::atomic<int>> counts(numTimelines);
+
+    Scheduler scheduler(2);
+    for (int i = 0; i < numTimelines; ++i)
+    {
+        // Every timeline emits one event per tick; odd ones tick twice as fast.
+        auto timeline = std::make_shared<Timeline>(i % 2 ? 1200 : 600, 4);
+        timeline->addTrack(std::make_shared<Track>("t", std::make_shared<PSeries>(0, 1), nullptr,
+                                                   std::make_shared<PSequence>(std::vector<double>{0.25})));
+        timeline->attachOutput([&counts, i](const Event &) { counts[i]++; });
+        timelines.push_back(timeline);
+        scheduler.add(timeline);
+    }
+    CHECK(scheduler.size() == numTimelines);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    scheduler.remove(timelines[0]);
+    int frozen = counts[0].load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    scheduler.stop();
+
+    CHECK(scheduler.size() == numTimelines - 1);
+    CHECK(counts[0].load() == frozen);
+    long slow = 0, fast = 0;
+    for (int i = 2; i < numTimelines; ++i)
+    {
+        CHECK(counts[i].load() > 0);
+        (i % 2 ? fast : slow) += counts[i].load();
+    }
+    CHECK(fast > slow);
+    CHECK(scheduler.getTotalTicks() > 0);
+}
+
+TEST_CASE("Scheduler follows tempo changes")
+{
+    auto timeline = std::make_shared<Timeline>(600, 4);
+    timeline->addTrack(std::make_shared<Track>("t", std::make_shared<PSeries>(0, 1), nullptr,
+                                               std::make_shared<PSequence>(std::vector<double>{0.25})));
+    std::atomic<int> count(0);
+    timeline->attachOutput([&count](const Event &) { count++; });
+
+    // 40 ticks per second, then 400.
+    Scheduler scheduler;
+    scheduler.add(timeline);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int slow = count.exchange(0);
+    timeline->setTempo(6000);
+    CHECK(timeline->getTempo() == 6000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int fast = count.load();
+    scheduler.stop();
+
+    CHECK(slow > 0);
+    CHECK(fast > 3 * slow);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "../Sequence.h"
+
+#include "doctest.h"
+
+TEST_CASE("PSequence repeats and exhausts")
+{
+    PSequence seq({1, 2, 3}, 2);
+    std::vector<double> out;
+    for (int i = 0; i < 6; ++i) out.push_back(seq.next());
+    CHECK(out == std::vector<double>({1, 2, 3, 1, 2, 3}));
+    CHECK_THROWS_AS(seq.next(), std::out_of_range);
+    seq.reset();
+    CHECK(seq.next() == 1);
+    CHECK_THROWS_AS(PSequence(std::vector<double>{}), std::invalid_argument);
+}
+
+TEST_CASE("PSequence shares one table across instances")
+{
+    auto motif = std::make_shared<const std::vector<double>>(std::vector<double>{60, 64, 67});
+    std::vector<PSequence> tracks;
+    for (int i = 0; i < 100; ++i)
+    {
+        tracks.emplace_back(motif);
+    }
+    PSequence copy = tracks.front();
+
+    CHECK(motif.use_count() == 102);
+    CHECK(copy.values().data() == motif->data());
+    CHECK(tracks[99].values().data() == motif->data());
+    CHECK(tracks[5].next() == 60);
+    CHECK(tracks[5].next() == 64);
+    CHECK(tracks[6].next() == 60);
+}
+
+TEST_CASE("PSequence over caller-owned and aliased storage")
+{
+    const double table[] = {1, 2, 3, 4};
+    PSequence view(std::span<const double>(table, 2));
+    CHECK(view.values().data() == table);
+    CHECK(view.next() == 1);
+    CHECK(view.next() == 2);
+    CHECK(view.next() == 1);
+
+    auto block = std::make_shared<std::vector<double>>(std::vector<double>{9, 8, 7, 6});
+    PSequence slice(block, std::span<const double>(block->data() + 2, 2), 1);
+    block.reset(); // the pattern keeps the storage alive
+    CHECK(slice.next() == 7);
+    CHECK(slice.next() == 6);
+    CHECK_THROWS_AS(slice.next(), std::out_of_range);
+}
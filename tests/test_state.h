@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "../Sequence.h"
+#include "../Operators.h"
+#include "../Markov.h"
+#include "../Timeline.h"
+
+#include "doctest.h"
+
+static std::shared_ptr<Pattern> buildStateGraph()
+{
+    auto melody = std::make_shared<PLoop>(std::make_shared<PSequence>(std::vector<double>{0, 2, 4}, 2), 3);
+    auto model = MarkovModel::train(std::vector<std::vector<double>>{{1, 2, 1, 3, 2, 1, 3}}, 1);
+    return (melody + std::make_shared<PSeries>(0, 0.5)) * 2 + std::make_shared<PMarkov>(model, 7);
+}
+
+static std::vector<double> take(Pattern &pattern, int count)
+{
+    std::vector<double> values;
+    for (int i = 0; i < count; ++i) values.push_back(pattern.next());
+    return values;
+}
+
+TEST_CASE("Pattern snapshots restore positions, loop recordings and RNG state")
+{
+    auto original = buildStateGraph();
+    take(*original, 4);
+    Snapshot snapshot = saveState(*original);
+    std::vector<double> expected = take(*original, 12);
+
+    auto fork = buildStateGraph();
+    loadState(*fork, snapshot);
+    CHECK(take(*fork, 12) == expected);
+
+    loadState(*original, snapshot);
+    CHECK(take(*original, 12) == expected);
+
+    CHECK_THROWS_AS(loadState(*std::make_shared<PSeries>(0, 1), snapshot), std::runtime_error);
+    snapshot.pop_back();
+    CHECK_THROWS_AS(loadState(*buildStateGraph(), snapshot), std::runtime_error);
+}
+
+TEST_CASE("A snapshot that fails to load leaves the graph untouched")
+{
+    auto graph = buildStateGraph();
+    Snapshot start = saveState(*graph);
+    take(*graph, 5);
+    Snapshot before = saveState(*graph);
+
+    // Truncated after the first nodes have already been read back.
+    start.resize(start.size() - 3);
+    CHECK_THROWS_AS(loadState(*graph, start), std::runtime_error);
+    CHECK(saveState(*graph) == before);
+}
+
+TEST_CASE("Timeline snapshots fork the playhead and every track")
+{
+    auto build = []()
+    {
+        auto timeline = std::make_unique<Timeline>(120, 4);
+        timeline->addTrack(std::make_shared<Track>("bass", std::make_shared<PSeries>(36, 1),
+                                                   nullptr, std::make_shared<PSequence>(std::vector<double>{0.5, 0.25})));
+        timeline->addTrack(std::make_shared<Track>("lead", std::make_shared<PLoop>(
+            std::make_shared<PSequence>(std::vector<double>{72, 74, 76}, 1))));
+        return timeline;
+    };
+
+    auto original = build();
+    std::vector<Event> events;
+    original->render(10, events);
+    Snapshot snapshot = original->saveState();
+    events.clear();
+    original->render(20, events);
+
+    auto fork = build();
+    fork->loadState(snapshot);
+    CHECK(fork->getCurrentTick() == 10);
+    std::vector<Event> forked;
+    fork->render(20, forked);
+    REQUIRE(forked.size() == events.size());
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        CHECK(forked[i].tick == events[i].tick);
+        CHECK(forked[i].note == events[i].note);
+        CHECK(forked[i].duration == events[i].duration);
+    }
+
+    Timeline other(120, 4);
+    CHECK_THROWS_AS(other.loadState(snapshot), std::runtime_error);
+
+    Snapshot current = original->saveState();
+    snapshot.pop_back();
+    CHECK_THROWS_AS(original->loadState(snapshot), std::runtime_error);
+    CHECK(original->getCurrentTick() == 30);
+    CHECK(original->saveState() == current);
+}
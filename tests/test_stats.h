@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "../Stats.h"
+#include "../Sequence.h"
+#include "../Timeline.h"
+
+#include "doctest.h"
+
+TEST_CASE("Histogram buckets are contiguous and bound the relative error")
+{
+    CHECK(Histogram::indexOf(0) == 0);
+    CHECK(Histogram::indexOf(15) == 15);
+    CHECK(Histogram::indexOf(16) == 16);
+    CHECK(Histogram::indexOf(~std::uint64_t(0)) == Histogram::NumBuckets - 1);
+
+    for (int i = 0; i + 1 < Histogram::NumBuckets; ++i)
+    {
+        CHECK(Histogram::indexOf(Histogram::upperBound(i)) == i);
+        CHECK(Histogram::indexOf(Histogram::upperBound(i) + 1) == i + 1);
+    }
+
+    for (std::uint64_t value : {17ull, 1000ull, 123456ull, 987654321ull})
+    {
+        double bound = static_cast<double>(Histogram::upperBound(Histogram::indexOf(value)));
+        CHECK(bound >= value);
+        CHECK(bound <= value * 1.0625);
+    }
+}
+
+TEST_CASE("Histogram percentiles")
+{
+    Histogram histogram;
+    for (std::uint64_t v = 1; v <= 1000; ++v) histogram.record(v);
+
+    HistogramSnapshot s = histogram.snapshot();
+    CHECK(s.count == 1000);
+    CHECK(s.max == 1000);
+    CHECK(s.sum == 500500);
+    CHECK(s.percentile(0.5) >= 500);
+    CHECK(s.percentile(0.5) <= 532);
+    CHECK(s.percentile(0.99) >= 990);
+    CHECK(s.percentile(1.0) == 1000);
+
+    histogram.reset();
+    CHECK(histogram.snapshot().count == 0);
+    CHECK(histogram.snapshot().percentile(0.99) == 0);
+}
+
+TEST_CASE("Clock and timeline record tick statistics")
+{
+    Timeline timeline(600.0, 24); // ~4.2 ms per tick
+    timeline.addTrack(std::make_shared<Track>("lead", std::make_shared<PSequence>(std::vector<double>{60, 62})));
+    timeline.setTrackTiming(true);
+    timeline.attachOutput([](const Event &) {});
+
+    timeline.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    timeline.stop();
+
+    ClockStats clock = timeline.clockStats();
+    CHECK(clock.ticks > 0);
+    CHECK(clock.lateness.count == clock.ticks);
+    CHECK(clock.callback.count == clock.ticks);
+
+    TimelineStats stats = timeline.stats();
+    CHECK(stats.tick.count == clock.ticks);
+    REQUIRE(stats.tracks.size() == 1);
+    CHECK(stats.tracks[0].name == "lead");
+    CHECK(stats.tracks[0].evaluations == clock.ticks);
+    CHECK(stats.tracks[0].maxNanos <= stats.tracks[0].totalNanos);
+
+    timeline.resetStats();
+    CHECK(timeline.clockStats().ticks == 0);
+    CHECK(timeline.stats().tick.count == 0);
+}
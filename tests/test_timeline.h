@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "../Sequence.h"
+#include "../Timeline.h"
+#include "../ThreadPool.h"
+
+#include "doctest.h"
+
+static std::vector<Event> renderTracks(const std::shared_ptr<ThreadPool>& pool, int numTracks, Tick numTicks)
+{
+    Timeline timeline(120, 4);
+    timeline.setThreadPool(pool);
+    for (int i = 0; i < numTracks; ++i)
+    {
+        auto notes = std::make_shared<PSeries>(i, 1);
+        auto durations = std::make_shared<PSequence>(std::vector<double>{0.25, 0.5, 0.75 + 0.25 * (i % 3)});
+        timeline.addTrack(std::make_shared<Track>("track" + std::to_string(i), notes, nullptr, durations));
+    }
+
+    std::vector<Event> events;
+    timeline.render(numTicks, events);
+    return events;
+}
+
+TEST_CASE("ThreadPool parallelFor visits every index once")
+{
+    ThreadPool pool(3);
+    std::vector<std::atomic<int>> visits(1000);
+    pool.parallelFor(visits.size(), [&](size_t i) { visits[i]++; });
+    for (auto& v : visits)
+    {
+        CHECK(v.load() == 1);
+    }
+    CHECK_THROWS_AS(pool.parallelFor(10, [](size_t i) { if (i == 7) throw std::runtime_error("boom"); }),
+                    std::runtime_error);
+}
+
+TEST_CASE("Timeline render orders events by tick then track")
+{
+    auto events = renderTracks(nullptr, 3, 8);
+    REQUIRE(events.size() == 12);
+    CHECK(events[0].tick == 0);
+    CHECK(events[0].track == 0);
+    CHECK(events[1].track == 1);
+    CHECK(events[2].track == 2);
+    for (size_t i = 1; i < events.size(); ++i)
+    {
+        bool ordered = events[i - 1].tick < events[i].tick ||
+                       (events[i - 1].tick == events[i].tick && events[i - 1].track < events[i].track);
+        CHECK(ordered);
+    }
+}
+
+TEST_CASE("Timeline parallel evaluation matches serial")
+{
+    auto serial = renderTracks(nullptr, 64, 200);
+    for (unsigned threads : {1u, 2u, 7u})
+    {
+        auto parallel = renderTracks(std::make_shared<ThreadPool>(threads), 64, 200);
+        REQUIRE(parallel.size() == serial.size());
+        for (size_t i = 0; i < serial.size(); ++i)
+        {
+            CHECK(parallel[i].tick == serial[i].tick);
+            CHECK(parallel[i].track == serial[i].track);
+            CHECK(parallel[i].note == serial[i].note);
+        }
+    }
+}
+
+TEST_CASE("Track finishes when its pattern is exhausted")
+{
+    Timeline timeline(120, 1);
+    timeline.addTrack(std::make_shared<Track>("short", std::make_shared<PSequence>(std::vector<double>{60, 62}, 1)));
+    std::vector<Event> events;
+    timeline.render(10, events);
+    CHECK(events.size() == 2);
+}
+
+TEST_CASE("TimeBase converts exactly between ticks, beats, seconds and frames")
+{
+    TimeBase base(120, 480);
+    CHECK(base.getMicrosPerBeat() == 500000);
+    CHECK(base.beatsToTicks(1.5) == 720);
+    CHECK(base.ticksToBeats(240) == 0.5);
+    CHECK(base.ticksToSeconds(480) == 0.5);
+    CHECK(base.secondsToTicks(2.0) == 1920);
+
+    // One tick every 1.0416.. ms: ten million ticks later there is no drift.
+    const Tick far = 10000000;
+    CHECK(base.ticksToNanos(far) == 10416666666667LL);
+    CHECK(base.nanosToTicks(base.ticksToNanos(far)) == far);
+
+    for (Tick t = 0; t < 2000; ++t)
+    {
+        std::int64_t frame = base.ticksToFrames(t, 44100);
+        CHECK(base.framesToTicks(frame, 44100) == t);
+        CHECK(base.framesToTicks(frame + 1, 44100) == t + 1);
+    }
+
+    CHECK(TimeBase::fromMicrosPerBeat(600000, 96).getTempo() == 100.0);
+    CHECK_THROWS_AS(TimeBase(0, 480), std::invalid_argument);
+    CHECK_THROWS_AS(TimeBase(-120, 480), std::invalid_argument);
+    CHECK_THROWS_AS(TimeBase(std::nan(""), 480), std::invalid_argument);
+}
+
+TEST_CASE("mulDiv rounds 128-bit products exactly")
+{
+    CHECK(mulDiv(7, 3, 2) == 10);
+    CHECK(mulDiv(7, 3, 2, true) == 11);
+    CHECK(mulDiv(-7, 3, 2) == -11);
+    CHECK(mulDiv(-7, 3, 2, true) == -10);
+    CHECK(mulDiv(0, 5, 3, true) == 0);
+
+    // Products far beyond 64 bits: (2^62 + 1) * 2^40 / 2^41 and a divisor
+    // whose top bit is set.
+    const std::int64_t big = (std::int64_t(1) << 62) + 1;
+    CHECK(mulDiv(big, std::int64_t(1) << 40, std::int64_t(1) << 41) == big / 2);
+    CHECK(mulDiv(big, std::int64_t(1) << 40, std::int64_t(1) << 41, true) == big / 2 + 1);
+    const std::int64_t large = INT64_MAX - 12345;
+    CHECK(mulDiv(large, INT64_MAX - 1, INT64_MAX) == large - 1);
+    CHECK(mulDiv(large, INT64_MAX - 1, INT64_MAX, true) == large);
+    CHECK(mulDiv(999999999999LL, 1000000007LL, 1000000009LL) == 999999997999LL);
+    CHECK_THROWS_AS(mulDiv(INT64_MAX, 4, 2), std::overflow_error);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Trace.h"
+#include "../Timeline.h"
+
+#include "doctest.h"
+
+TEST_CASE("Tracer drains per-thread rings to a file")
+{
+    const std::string path = "test_trace.log";
+    Tracer &tracer = Tracer::instance();
+    tracer.start(path, 256);
+    tracer.setLevel(TraceLevel::Info);
+
+    std::thread worker([]() {
+        for (int i = 0; i < 10; ++i)
+        {
+            Tracer::instance().record(TraceLevel::Info, "worker", Event{i, 7, 0, 60 + i, 100, 12});
+        }
+    });
+    tracer.record(TraceLevel::Error, "main thread");
+    tracer.record(TraceLevel::Debug, "filtered out");
+    worker.join();
+    tracer.stop();
+    tracer.setLevel(TraceLevel::Debug);
+
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) lines.push_back(line);
+    std::remove(path.c_str());
+
+    REQUIRE(lines.size() == 11);
+    int workerLines = 0;
+    for (const auto &line : lines)
+    {
+        CHECK(line.find("filtered out") == std::string::npos);
+        if (line.find("worker track=7") != std::string::npos) workerLines++;
+    }
+    CHECK(workerLines == 10);
+    CHECK(tracer.getDropped() == 0);
+
+    // Recording while stopped is a no-op.
+    tracer.record(TraceLevel::Error, "ignored");
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "../Voice.h"
+#include "../Sequence.h"
+#include "../Timeline.h"
+
+#include "doctest.h"
+
+TEST_CASE("Voice pools match note-offs and retrigger sounding notes")
+{
+    std::vector<VoiceEvent> out;
+    auto record = [&out](const VoiceEvent &event) { out.push_back(event); };
+    VoicePool pool(4);
+
+    int c = pool.noteOn(0, 60, 100, 10, record);
+    int e = pool.noteOn(0, 64, 100, 5, record);
+    CHECK(c != e);
+    CHECK(pool.voiceFor(64) == e);
+    CHECK(pool.noteOff(2, 64, record));
+    CHECK_FALSE(pool.noteOff(3, 64, record));
+    CHECK(out.back().voice == e);
+    CHECK_FALSE(out.back().on);
+
+    out.clear();
+    pool.noteOn(4, 60, 90, 12, record);
+    REQUIRE(out.size() == 2);
+    CHECK((!out[0].on && out[0].note == 60 && out[0].tick == 4));
+    CHECK((out[1].on && out[1].velocity == 90));
+    CHECK(pool.active() == 1);
+
+    out.clear();
+    pool.noteOn(5, 67, 100, 8, record);
+    pool.releaseUntil(20, record);
+    REQUIRE(out.size() == 3);
+    CHECK((out[1].note == 67 && out[1].tick == 8));
+    CHECK((out[2].note == 60 && out[2].tick == 12));
+    CHECK(pool.active() == 0);
+}
+
+TEST_CASE("Full voice pools steal by policy")
+{
+    auto victim = [](StealPolicy policy)
+    {
+        std::vector<VoiceEvent> out;
+        auto record = [&out](const VoiceEvent &event) { out.push_back(event); };
+        VoicePool pool(3, policy);
+        pool.noteOn(0, 64, 80, 30, record);
+        pool.noteOn(1, 60, 100, 10, record);
+        pool.noteOn(2, 67, 60, 20, record);
+        out.clear();
+        if (pool.noteOn(3, 72, 100, 40, record) < 0) return -1;
+        CHECK(pool.getStolen() == 1);
+        return out.front().on ? -2 : out.front().note;
+    };
+    CHECK(victim(StealPolicy::Oldest) == 64);
+    CHECK(victim(StealPolicy::SoonestEnd) == 60);
+    CHECK(victim(StealPolicy::Quietest) == 67);
+    CHECK(victim(StealPolicy::Lowest) == 60);
+    CHECK(victim(StealPolicy::Highest) == 67);
+    CHECK(victim(StealPolicy::None) == -1);
+}
+
+TEST_CASE("Timeline releases track voices after their duration")
+{
+    Timeline timeline(120, 4);
+    auto track = std::make_shared<Track>("pad", std::make_shared<PSequence>(std::vector<double>{60, 62}, 1),
+                                         nullptr, std::make_shared<PSequence>(std::vector<double>{0.5, 1}));
+    track->setVoices(2);
+    timeline.addTrack(track);
+    std::vector<VoiceEvent> out;
+    timeline.attachVoiceOutput([&out](const VoiceEvent &event) { out.push_back(event); });
+
+    for (int i = 0; i < 8; ++i) timeline.tick();
+    REQUIRE(out.size() == 4);
+    CHECK((out[0].on && out[0].note == 60 && out[0].tick == 0));
+    CHECK((!out[1].on && out[1].note == 60 && out[1].tick == 2));
+    CHECK((out[2].on && out[2].note == 62 && out[2].tick == 2));
+    CHECK((!out[3].on && out[3].note == 62 && out[3].tick == 6));
+    CHECK(track->getVoices()->active() == 0);
+}
+
+TEST_CASE("Timeline render and process allocate voices in tick order")
+{
+    auto build = [](Timeline &timeline)
+    {
+        for (double note : {60.0, 72.0})
+        {
+            auto track = std::make_shared<Track>("pad", std::make_shared<PSequence>(std::vector<double>{note, note + 2}, 1),
+                                                 nullptr, std::make_shared<PSequence>(std::vector<double>{0.5, 1}));
+            track->setVoices(2);
+            timeline.addTrack(track);
+        }
+    };
+
+    Timeline ticked(120, 4);
+    build(ticked);
+    std::vector<VoiceEvent> expected;
+    ticked.attachVoiceOutput([&expected](const VoiceEvent &event) { expected.push_back(event); });
+    for (int i = 0; i < 8; ++i) ticked.tick();
+    REQUIRE(expected.size() == 8);
+
+    Timeline rendered(120, 4);
+    build(rendered);
+    std::vector<VoiceEvent> out;
+    rendered.attachVoiceOutput([&out](const VoiceEvent &event) { out.push_back(event); });
+    std::vector<Event> events;
+    rendered.render(8, events);
+    REQUIRE(out.size() == expected.size());
+    for (size_t i = 0; i < out.size(); ++i)
+    {
+        CHECK((out[i].tick == expected[i].tick && out[i].track == expected[i].track &&
+               out[i].note == expected[i].note && out[i].on == expected[i].on));
+    }
+
+    // 125 frames per tick at 120 bpm, 4 ticks per beat and 1 kHz.
+    Timeline processed(120, 4);
+    build(processed);
+    out.clear();
+    processed.attachVoiceOutput([&out](const VoiceEvent &event) { out.push_back(event); });
+    std::vector<BlockEvent> block;
+    for (int i = 0; i < 4; ++i) processed.process(250, 1000, block);
+    REQUIRE(out.size() == expected.size());
+    for (size_t i = 0; i < out.size(); ++i)
+    {
+        CHECK((out[i].tick == expected[i].tick && out[i].note == expected[i].note && out[i].on == expected[i].on));
+    }
+}
+
+TEST_CASE("Timeline loadState releases sounding voices")
+{
+    Timeline timeline(120, 4);
+    auto track = std::make_shared<Track>("pad", std::make_shared<PSequence>(std::vector<double>{60, 62}),
+                                         nullptr, std::make_shared<PSequence>(std::vector<double>{4}));
+    track->setVoices(2);
+    timeline.addTrack(track);
+    Snapshot start = timeline.saveState();
+    std::vector<VoiceEvent> out;
+    timeline.attachVoiceOutput([&out](const VoiceEvent &event) { out.push_back(event); });
+
+    timeline.tick();
+    REQUIRE(track->getVoices()->active() == 1);
+    timeline.loadState(start);
+    REQUIRE(out.size() == 2);
+    CHECK((!out[1].on && out[1].note == 60 && out[1].tick == 1));
+    CHECK(track->getVoices()->active() == 0);
+
+    // The restored start plays its first note again.
+    timeline.tick();
+    CHECK((out.back().on && out.back().note == 60 && out.back().tick == 0));
+}